@@ -0,0 +1,267 @@
+#ifndef ANALYSIS_HPP
+#define ANALYSIS_HPP
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <algorithm>
+#include "top.hpp"
+
+// Closed-form estimate of one station of the LBS, or its measure over a run
+struct stationEstimate {
+    std::string name;
+    double arrival = 0;      // jobs per second
+    double utilisation = 0;  // busy fraction of a worker; processing only for a server, as in its report
+    double throughput = 0;   // jobs per second
+    double sojourn = std::numeric_limits<double>::quiet_NaN();  // mean time from the arrival to the departure, infinite when saturated, NaN when not measured
+};
+
+// Open queueing network of Top_coupled: balancer, then one server per job, then the db server
+struct queueingEstimate {
+    std::vector<stationEstimate> stations;  // balancer, servers 1 to n, db server
+    double response = 0;                    // mean time from the generator to the DB acknowledgment
+    std::vector<std::string> notes;         // parts of the configuration the model leaves out
+};
+
+namespace queueing {
+
+    constexpr double INF = std::numeric_limits<double>::infinity();
+
+    // probability that a job waits in an M/M/c queue with offered load a = lambda * service (Erlang C)
+    inline double erlangC(int c, double a) {
+        if (a >= c) {
+            return 1.0;
+        }
+        double term = 1.0;  // a^k / k!
+        double sum = 1.0;
+        for (int k = 1; k < c; k++) {
+            term *= a / k;
+            sum += term;
+        }
+        double last = term * a / c * (c / (c - a));  // a^c / c! * c / (c - a)
+        return last / (sum + last);
+    }
+
+    // mean wait in a GI/G/c queue (Allen-Cunneen): the M/M/c wait scaled by the squared
+    // coefficients of variation of the inter-arrival (ca2) and service (cs2) times.
+    // Exact for M/M/c and for M/G/1 (Pollaczek-Khinchine).
+    inline double wait(double lambda, double service, int c, double ca2, double cs2) {
+        if (lambda <= 0 || service <= 0) {
+            return 0.0;
+        }
+        double rho = lambda * service / c;
+        if (rho >= 1) {
+            return INF;
+        }
+        return (ca2 + cs2) / 2 * erlangC(c, lambda * service) * service / (c * (1 - rho));
+    }
+
+    // squared coefficient of variation of the departures of a GI/G/c queue (Whitt)
+    inline double departureScv(double rho, int c, double ca2, double cs2) {
+        rho = std::min(rho, 1.0);
+        return 1 + (1 - rho * rho) * (ca2 - 1) + rho * rho * (cs2 - 1) / std::sqrt(static_cast<double>(c));
+    }
+
+    inline double scv(distributionType type) {
+        return type == distributionType::exponential ? 1.0 : 0.0;
+    }
+}
+
+// Predicts the stations of the LBS of a configuration. The generator is a renewal
+// source (with the rate and variability of the request log it replays, if any); the balancer is a GI/G/c queue (c = dispatch workers) and splits its
+// output by the policy's long-run shares (speeds, or equal shares for modulo);
+// each server is a GI/G/1 queue whose service is its processing plus the DB
+// round trip it blocks on; the db server is an M/D/1 queue fed by every server.
+inline queueingEstimate predict(const topConfig& config) {
+    const lbsConfig& lbs = config.lbs;
+    queueingEstimate estimate;
+
+    double lambda = config.interarrival > 0 ? 1.0 / config.interarrival : 0.0;
+    double ca2 = queueing::scv(config.arrival_type);
+    if (config.trace.size() > 1) {
+        // a replayed request log: rate and variability of its inter-arrival times
+        double mean = config.trace.back().time / static_cast<double>(config.trace.size() - 1);
+        double square = 0.0;
+        for (std::size_t k = 1; k < config.trace.size(); k++) {
+            double gap = config.trace[k].time - config.trace[k - 1].time;
+            square += gap * gap;
+        }
+        square /= static_cast<double>(config.trace.size() - 1);
+        lambda = mean > 0 ? 1.0 / mean : 0.0;
+        ca2 = mean > 0 ? square / (mean * mean) - 1 : 0.0;
+    }
+
+    // balancer
+    int workers = std::max(1, lbs.dispatch_workers);
+    stationEstimate bal{"balancer", lambda};
+    double dispatch_cs2 = queueing::scv(lbs.dispatch_type);
+    bal.throughput = lbs.dispatch_time > 0 ? std::min(lambda, workers / lbs.dispatch_time) : lambda;
+    bal.utilisation = bal.throughput * lbs.dispatch_time / workers;
+    bal.sojourn = queueing::wait(lambda, lbs.dispatch_time, workers, ca2, dispatch_cs2) + lbs.dispatch_time;
+    double out_ca2 = queueing::departureScv(bal.utilisation, workers, ca2, dispatch_cs2);
+    estimate.stations.push_back(bal);
+
+    // long-run share of the dispatched jobs sent to each server; modulo and round-robin
+    // send every n-th job to a server, the other policies split the stream at random
+    balancerConfig routing = lbs.balancer();
+    bool cyclic = (routing.policy == balancerPolicy::modulo || routing.policy == balancerPolicy::weighted_round_robin);
+    std::vector<double> share(lbs.servers, 0.0);
+    double total = 0.0;
+    for (int i = 0; i < routing.active_servers; i++) {
+        share[i] = (routing.policy == balancerPolicy::modulo) ? 1.0 : routing.weights[i];
+        total += share[i];
+    }
+    for (auto& p : share) {
+        p = total > 0 ? p / total : 0.0;
+    }
+
+    // db server: every job a server finishes processing queries it once; a server
+    // waits for at least the DB service, which bounds the rate it can query at
+    double db_lambda = 0.0;
+    for (int i = 0; i < lbs.servers; i++) {
+        double service = lbs.server_mean[i] / lbs.server_speed[i] + lbs.db_time;
+        db_lambda += std::min(share[i] * bal.throughput, 1.0 / service);
+    }
+    stationEstimate db{"db server", db_lambda};
+    db.utilisation = db_lambda * lbs.db_time;
+    db.throughput = lbs.db_time > 0 ? std::min(db_lambda, 1.0 / lbs.db_time) : db_lambda;
+    double db_wait = queueing::wait(db_lambda, lbs.db_time, 1, 1.0, 0.0);
+    db.sojourn = db_wait + lbs.db_time;
+
+    // servers; with a saturated DB the servers share its capacity
+    estimate.response = bal.sojourn;
+    for (int i = 0; i < lbs.servers; i++) {
+        double processing = lbs.server_mean[i] / lbs.server_speed[i];
+        double service = processing + db.sojourn;
+        double variance = queueing::scv(lbs.service_type) * processing * processing + db_wait * db_wait;
+        stationEstimate srv{"server " + std::to_string(i + 1), share[i] * bal.throughput};
+        if (std::isinf(service)) {
+            srv.throughput = db_lambda > 0 ? srv.arrival * db.throughput / db_lambda : 0.0;
+            srv.sojourn = queueing::INF;
+        } else {
+            double arrival_ca2 = share[i] * out_ca2 + (cyclic ? 0.0 : 1 - share[i]);
+            srv.throughput = std::min(srv.arrival, 1.0 / service);
+            srv.sojourn = queueing::wait(srv.arrival, service, 1, arrival_ca2, variance / (service * service)) + service;
+        }
+        srv.utilisation = srv.throughput * processing;
+        if (share[i] > 0) {
+            estimate.response += share[i] * srv.sojourn;
+        }
+        estimate.stations.push_back(srv);
+    }
+    estimate.stations.push_back(db);
+
+    std::vector<std::pair<bool, const char*>> left_out = {
+        {lbs.faults.enabled(), "faults"}, {lbs.autoscaling.enabled, "autoscaling"}, {lbs.stealing.enabled, "work stealing"},
+        {lbs.hedging.enabled, "hedging"}, {lbs.server_cache.enabled(), "session cache"}, {lbs.db_batching.enabled(), "db batching"},
+        {lbs.db_cache.enabled, "db cache"}, {lbs.dispatch_link.enabled() || lbs.db_link.enabled(), "network links"}};
+    for (const auto& [enabled, name] : left_out) {
+        if (enabled) {
+            estimate.notes.emplace_back(name);
+        }
+    }
+    if (lbs.max_jobs > 0) {
+        estimate.notes.emplace_back("load shedding");
+    }
+    if (lbs.policy == balancerPolicy::weighted_least_loaded || lbs.load_factor > 0) {
+        estimate.notes.emplace_back("load-dependent routing (static shares used)");
+    }
+    return estimate;
+}
+
+// Measures the same stations on a flat engine that ran over [0, flat.getTime()]
+template<typename FLAT>
+std::vector<stationEstimate> measure(const FLAT& flat, const topConfig& config) {
+    const lbsConfig& lbs = config.lbs;
+    double t = flat.getTime();
+    std::vector<stationEstimate> measured;
+    if (t <= 0) {
+        return measured;
+    }
+
+    const auto& bal = flat.bal.getState();
+    int dispatched = 0;
+    for (int i = 0; i < lbs.servers; i++) {
+        dispatched += bal.dispatched[i];
+    }
+    stationEstimate b{"balancer", flat.gen.jobsGenerated(flat.gen.getState()) / t};
+    b.throughput = dispatched / t;
+    b.utilisation = b.throughput * lbs.dispatch_time / std::max(1, lbs.dispatch_workers);
+    measured.push_back(b);
+
+    for (int i = 0; i < lbs.servers; i++) {
+        const auto& srv = flat.srv[i].getState();
+        latencyStats latency;
+        for (const auto& l : srv.latency) {
+            latency.merge(l);
+        }
+        stationEstimate s{"server " + std::to_string(i + 1), bal.dispatched[i] / t};
+        s.throughput = srv.jobs_done / t;
+        s.utilisation = srv.busy_time / t;
+        s.sojourn = latency.mean();
+        measured.push_back(s);
+    }
+
+    const auto& db = flat.db.getState();
+    stationEstimate d{"db server", db.jobs_done / t};
+    d.throughput = db.jobs_done / t;
+    d.utilisation = lbs.db_batching.enabled() ? db.busy_time / t : db.jobs_done * lbs.db_time / t;
+    if (lbs.db_batching.enabled()) {
+        d.sojourn = db.latency.mean();
+    }
+    measured.push_back(d);
+    return measured;
+}
+
+// one line per station: the prediction, and the measure with the relative error when given
+inline void printEstimate(std::ostream& os, const queueingEstimate& estimate, const std::vector<stationEstimate>& measured = {}) {
+    auto value = [&os](double predicted, const stationEstimate* m, double stationEstimate::*field, double scale, const char* unit) {
+        if (std::isinf(predicted)) {
+            os << "saturated";
+        } else {
+            os << predicted * scale << unit;
+        }
+        if (m == nullptr) {
+            return;
+        }
+        double actual = m->*field;
+        if (std::isnan(actual)) {
+            os << " (not measured)";
+        } else {
+            os << " (measured " << actual * scale << unit;
+            if (actual != 0 && !std::isinf(predicted)) {
+                os << ", error " << 100.0 * (predicted - actual) / actual << "%";
+            }
+            os << ")";
+        }
+    };
+
+    for (std::size_t k = 0; k < estimate.stations.size(); k++) {
+        const stationEstimate& s = estimate.stations[k];
+        const stationEstimate* m = k < measured.size() ? &measured[k] : nullptr;
+        os << s.name << ": arrival " << s.arrival << "/s, utilisation ";
+        value(s.utilisation, m, &stationEstimate::utilisation, 100.0, "%");
+        os << ", throughput ";
+        value(s.throughput, m, &stationEstimate::throughput, 1.0, "/s");
+        os << ", sojourn ";
+        value(s.sojourn, m, &stationEstimate::sojourn, 1.0, " s");
+        os << std::endl;
+    }
+    os << "response (balancer to DB acknowledgment): ";
+    if (std::isinf(estimate.response)) {
+        os << "saturated" << std::endl;
+    } else {
+        os << estimate.response << " s" << std::endl;
+    }
+    if (!estimate.notes.empty()) {
+        os << "not modelled:";
+        for (std::size_t k = 0; k < estimate.notes.size(); k++) {
+            os << (k == 0 ? " " : ", ") << estimate.notes[k];
+        }
+        os << std::endl;
+    }
+}
+
+#endif
@@ -0,0 +1,644 @@
+#ifndef FLAT_TOP_HPP
+#define FLAT_TOP_HPP
+
+#include <array>
+#include <limits>
+#include <algorithm>
+#include <random>
+#include <string>
+#include "../atomic_models/generator.hpp"
+#include "../atomic_models/balancer.hpp"
+#include "../atomic_models/server.hpp"
+#include "../atomic_models/dbserver.hpp"
+#include "../atomic_models/faultinjector.hpp"
+#include "../atomic_models/autoscaler.hpp"
+#include "../atomic_models/workstealer.hpp"
+#include "../atomic_models/dbcache.hpp"
+#include "../atomic_models/wanlink.hpp"
+#include "top.hpp"
+
+// Flattened, statically-typed variant of Top_coupled (generator + LBS).
+// Component types are template parameters and every coupling of top.hpp and
+// lbs.hpp is written out below as a direct, non-virtual call, so messages are
+// routed without going through Coupled, PortInterface or the coordinators.
+// Messages still travel in the components' Port<T> bags: route() copies each
+// message of an output bag into the input bag it is coupled to. The optional
+// components are always members; the flags set from the configuration decide
+// which of them are coupled, so the topology is not fixed at compile time.
+template<typename GEN = generator, typename BAL = balancer, typename SRV = server, typename DB = dbserver, typename FI = faultinjector, typename AS = autoscaler, typename WS = workstealer, typename DC = dbcache, typename WL = wanlink>
+class Flat_top {
+
+    // gives the simulator access to the state a component keeps in Atomic<S>
+    template<typename M>
+    struct component : public M {
+        using M::M;
+        auto& getState() { return this->state; }
+        const auto& getState() const { return this->state; }
+    };
+
+    // simulation times of one component
+    struct slot {
+        double tl;  // time of last event
+        double tn;  // time of next internal event
+    };
+
+    public:
+
+    static constexpr int MAX_SERVERS = lbsConfig::MAX_SERVERS;
+
+    component<GEN> gen;
+    component<BAL> bal;
+    std::array<component<SRV>, MAX_SERVERS> srv;
+    component<DB> db;
+    component<FI> inj;  // passive unless faults are configured
+    component<AS> scaler;  // disconnected unless autoscaling is enabled
+    component<WS> stealer;  // disconnected unless work stealing is enabled
+    component<DC> cache;  // disconnected unless the db cache is enabled
+    std::array<component<WL>, MAX_SERVERS> dispatch_link;  // disconnected unless the dispatch link is enabled
+    std::array<component<WL>, MAX_SERVERS> db_link;        // disconnected unless the db link is enabled
+
+    explicit Flat_top(const std::string& log_path = "simulation_results/flat_top_log.txt", unsigned int seed = std::random_device{}()) : Flat_top(topConfig(), log_path, seed) { }
+
+    // same parameters, seeds and component order as Top_coupled; servers past config.lbs.servers stay idle
+    // and the fault injector, the autoscaler, the work stealer, the db cache and the links only take part when they are enabled
+    explicit Flat_top(const topConfig& config, const std::string& log_path = "simulation_results/flat_top_log.txt", unsigned int seed = std::random_device{}())
+        : gen("generator", config.interarrival, log_path, config.arrival_type, seed + MAX_SERVERS, config.class_mix, config.sessions, config.trace),
+          bal("balancer", config.lbs.balancer(), log_path, seed + 3 * MAX_SERVERS + 3),
+          srv{{component<SRV>("server1", 1, config.lbs.server_mean[0], log_path, seed, config.lbs.service_type, config.lbs.server_speed[0], config.lbs.server_queueing, config.lbs.server_cache, config.lbs.stealing.cost, config.lbs.server_standin, config.lbs.timeline_windows),
+               component<SRV>("server2", 2, config.lbs.server_mean[1], log_path, seed + 1, config.lbs.service_type, config.lbs.server_speed[1], config.lbs.server_queueing, config.lbs.server_cache, config.lbs.stealing.cost, config.lbs.server_standin, config.lbs.timeline_windows),
+               component<SRV>("server3", 3, config.lbs.server_mean[2], log_path, seed + 2, config.lbs.service_type, config.lbs.server_speed[2], config.lbs.server_queueing, config.lbs.server_cache, config.lbs.stealing.cost, config.lbs.server_standin, config.lbs.timeline_windows)}},
+          db("db_server", config.lbs.db_time, log_path, config.lbs.db_queueing, config.lbs.db_batching),
+          inj("fault_injector", config.lbs.faults, config.lbs.servers, log_path, seed + MAX_SERVERS + 1),
+          scaler("autoscaler", config.lbs.autoscaling, config.lbs.servers, log_path),
+          stealer("work_stealer", config.lbs.stealing, config.lbs.servers, config.lbs.balancer().active_servers, log_path),
+          cache("db_cache", config.lbs.db_cache, log_path, seed + MAX_SERVERS + 2),
+          dispatch_link{{component<WL>("dispatch_link1", config.lbs.dispatch_link, log_path, seed + MAX_SERVERS + 3),
+                         component<WL>("dispatch_link2", config.lbs.dispatch_link, log_path, seed + MAX_SERVERS + 4),
+                         component<WL>("dispatch_link3", config.lbs.dispatch_link, log_path, seed + MAX_SERVERS + 5)}},
+          db_link{{component<WL>("db_link1", config.lbs.db_link, log_path, seed + 2 * MAX_SERVERS + 3),
+                   component<WL>("db_link2", config.lbs.db_link, log_path, seed + 2 * MAX_SERVERS + 4),
+                   component<WL>("db_link3", config.lbs.db_link, log_path, seed + 2 * MAX_SERVERS + 5)}},
+          servers(config.lbs.servers), faults(config.lbs.faults.enabled()), scaling(config.lbs.autoscaling.enabled), stealing(config.lbs.stealing.enabled),
+          hedging(config.lbs.hedging.enabled), caching(config.lbs.db_cache.enabled),
+          dispatch_linked(config.lbs.dispatch_link.enabled()), db_linked(config.lbs.db_link.enabled()), time(0.0), events(0), jobs_out(0) { }
+
+    void start() {
+        events = 0;
+        jobs_out = 0;
+        schedule(0.0);
+    }
+
+    // runs every event scheduled before time + interval (same convention as RootCoordinator::simulate)
+    void simulate(double interval) {
+        double time_final = time + interval;
+        double t = nextTime();
+        while (t < time_final) {
+            step(t);
+            t = nextTime();
+        }
+        time = time_final;
+    }
+
+    // checkpoint: same format as Top_coupled::save, so snapshots can be resumed by either model
+    void save(std::ostream& os) const {
+        snapshot::writeHeader(os, time);
+        gen.GEN::save(os, gen.getState(), time);
+        snapshot::write(os, false);  // no zones
+        snapshot::write(os, servers);
+        bal.BAL::save(os, bal.getState(), time);
+        for (int i = 0; i < servers; i++) {
+            srv[i].SRV::save(os, srv[i].getState(), time);
+        }
+        db.DB::save(os, db.getState(), time);
+        snapshot::write(os, faults);
+        if (faults) {
+            inj.FI::save(os, inj.getState(), time);
+        }
+        snapshot::write(os, scaling);
+        if (scaling) {
+            scaler.AS::save(os, scaler.getState(), time);
+        }
+        snapshot::write(os, stealing);
+        if (stealing) {
+            stealer.WS::save(os, stealer.getState(), time);
+        }
+        snapshot::write(os, caching);
+        if (caching) {
+            cache.DC::save(os, cache.getState(), time);
+        }
+        snapshot::write(os, dispatch_linked ? servers : 0);
+        for (int i = 0; dispatch_linked && i < servers; i++) {
+            dispatch_link[i].WL::save(os, dispatch_link[i].getState(), time);
+        }
+        snapshot::write(os, db_linked ? servers : 0);
+        for (int i = 0; db_linked && i < servers; i++) {
+            db_link[i].WL::save(os, db_link[i].getState(), time);
+        }
+    }
+
+    // checkpoint: restores a snapshot and schedules the next events from its simulation time
+    bool restore(std::istream& is) {
+        double t = 0.0;
+        if (!snapshot::readHeader(is, t)) {
+            return false;
+        }
+        bool snapshot_regions = false;
+        if (!gen.GEN::restore(is, gen.getState(), t) || !snapshot::read(is, snapshot_regions)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        if (snapshot_regions) {
+            std::cerr << "Error: snapshot has zones, the flat model has none" << std::endl;
+            return false;
+        }
+        int snapshot_servers = 0;
+        bool ok = snapshot::read(is, snapshot_servers);
+        if (ok && snapshot_servers != servers) {
+            std::cerr << "Error: snapshot has " << snapshot_servers << " servers, the model has " << servers << std::endl;
+            return false;
+        }
+        ok = ok && bal.BAL::restore(is, bal.getState(), t);
+        for (int i = 0; ok && i < servers; i++) {
+            ok = srv[i].SRV::restore(is, srv[i].getState(), t);
+        }
+        bool snapshot_faults = false;
+        if (!ok || !db.DB::restore(is, db.getState(), t) || !snapshot::read(is, snapshot_faults)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        if (snapshot_faults != faults) {
+            std::cerr << "Error: snapshot " << (snapshot_faults ? "has" : "has no") << " fault injector, the model " << (faults ? "has one" : "has none") << std::endl;
+            return false;
+        }
+        bool snapshot_scaling = false;
+        if ((faults && !inj.FI::restore(is, inj.getState(), t)) || !snapshot::read(is, snapshot_scaling)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        if (snapshot_scaling != scaling) {
+            std::cerr << "Error: snapshot " << (snapshot_scaling ? "has" : "has no") << " autoscaler, the model " << (scaling ? "has one" : "has none") << std::endl;
+            return false;
+        }
+        bool snapshot_stealing = false;
+        if ((scaling && !scaler.AS::restore(is, scaler.getState(), t)) || !snapshot::read(is, snapshot_stealing)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        if (snapshot_stealing != stealing) {
+            std::cerr << "Error: snapshot " << (snapshot_stealing ? "has" : "has no") << " work stealer, the model " << (stealing ? "has one" : "has none") << std::endl;
+            return false;
+        }
+        bool snapshot_caching = false;
+        if ((stealing && !stealer.WS::restore(is, stealer.getState(), t)) || !snapshot::read(is, snapshot_caching)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        if (snapshot_caching != caching) {
+            std::cerr << "Error: snapshot " << (snapshot_caching ? "has" : "has no") << " db cache, the model " << (caching ? "has one" : "has none") << std::endl;
+            return false;
+        }
+        int snapshot_links = 0;
+        if ((caching && !cache.DC::restore(is, cache.getState(), t)) || !snapshot::read(is, snapshot_links)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        if (snapshot_links != (dispatch_linked ? servers : 0)) {
+            std::cerr << "Error: snapshot has " << snapshot_links << " dispatch links, the model has " << (dispatch_linked ? servers : 0) << std::endl;
+            return false;
+        }
+        ok = true;
+        for (int i = 0; ok && dispatch_linked && i < servers; i++) {
+            ok = dispatch_link[i].WL::restore(is, dispatch_link[i].getState(), t);
+        }
+        if (!ok || !snapshot::read(is, snapshot_links)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        if (snapshot_links != (db_linked ? servers : 0)) {
+            std::cerr << "Error: snapshot has " << snapshot_links << " db links, the model has " << (db_linked ? servers : 0) << std::endl;
+            return false;
+        }
+        for (int i = 0; ok && db_linked && i < servers; i++) {
+            ok = db_link[i].WL::restore(is, db_link[i].getState(), t);
+        }
+        if (!ok) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        schedule(t);
+        return true;
+    }
+
+    // same metrics as Top_coupled::sample, at the current time
+    [[nodiscard]] metricsSample sample() const {
+        metricsSample m;
+        m.time = time;
+        m.generated = gen.GEN::jobsGenerated(gen.getState());
+        bal.BAL::sample(m, bal.getState());
+        for (int i = 0; i < servers; i++) {
+            srv[i].SRV::sample(m, srv[i].getState(), std::to_string(i + 1));
+        }
+        db.DB::sample(m, db.getState());
+        return m;
+    }
+
+    // same summary as Top_coupled::report
+    void report(std::ostream& os) const {
+        os << "generated jobs: " << gen.GEN::jobsGenerated(gen.getState()) << std::endl;
+        bal.BAL::report(os, bal.getState());
+        std::array<latencyStats, job::MAX_CLASSES> latency;
+        timeline completions;
+        int lost = 0;
+        for (int i = 0; i < servers; i++) {
+            srv[i].SRV::report(os, srv[i].getState(), time);
+            srv[i].SRV::collect(srv[i].getState(), latency, completions, lost);
+        }
+        db.DB::report(os, db.getState(), time);
+        if (caching) {
+            cache.DC::report(os, cache.getState(), time);
+        }
+        for (int i = 0; dispatch_linked && i < servers; i++) {
+            dispatch_link[i].WL::report(os, dispatch_link[i].getState(), time);
+        }
+        for (int i = 0; db_linked && i < servers; i++) {
+            db_link[i].WL::report(os, db_link[i].getState(), time);
+        }
+        if (scaling) {
+            scaler.AS::report(os, scaler.getState(), time);
+        }
+        if (stealing) {
+            stealer.WS::report(os, stealer.getState());
+        }
+        reportPool(os, latency, completions, lost, faults);
+    }
+
+    [[nodiscard]] double getTime() const { return time; }
+    [[nodiscard]] unsigned long getEvents() const { return events; }
+    [[nodiscard]] unsigned long getJobsOut() const { return jobs_out; }
+
+    private:
+
+    slot gen_t{};
+    slot bal_t{};
+    std::array<slot, MAX_SERVERS> srv_t{};
+    slot db_t{};
+    slot inj_t{};
+    slot scaler_t{};
+    slot stealer_t{};
+    slot cache_t{};
+    std::array<slot, MAX_SERVERS> dispatch_link_t{};
+    std::array<slot, MAX_SERVERS> db_link_t{};
+
+    int servers;
+    bool faults;
+    bool scaling;
+    bool stealing;
+    bool hedging;
+    bool caching;
+    bool dispatch_linked;
+    bool db_linked;
+    double time;
+    unsigned long events;    // number of state transitions executed
+    unsigned long jobs_out;  // messages that reached Top_coupled::out
+
+    template<typename M>
+    static void init(const component<M>& model, slot& s, double t) {
+        s.tl = t;
+        s.tn = t + model.M::timeAdvance(model.getState());
+    }
+
+    void schedule(double t) {
+        time = t;
+        init(gen, gen_t, t);
+        init(bal, bal_t, t);
+        for (int i = 0; i < servers; i++) {
+            init(srv[i], srv_t[i], t);
+        }
+        for (int i = servers; i < MAX_SERVERS; i++) {
+            srv_t[i] = {t, std::numeric_limits<double>::infinity()};
+        }
+        init(db, db_t, t);
+        if (faults) {
+            init(inj, inj_t, t);
+        } else {
+            inj_t = {t, std::numeric_limits<double>::infinity()};
+        }
+        if (scaling) {
+            init(scaler, scaler_t, t);
+        } else {
+            scaler_t = {t, std::numeric_limits<double>::infinity()};
+        }
+        if (stealing) {
+            init(stealer, stealer_t, t);
+        } else {
+            stealer_t = {t, std::numeric_limits<double>::infinity()};
+        }
+        if (caching) {
+            init(cache, cache_t, t);
+        } else {
+            cache_t = {t, std::numeric_limits<double>::infinity()};
+        }
+        for (int i = 0; i < MAX_SERVERS; i++) {
+            if (dispatch_linked && i < servers) {
+                init(dispatch_link[i], dispatch_link_t[i], t);
+            } else {
+                dispatch_link_t[i] = {t, std::numeric_limits<double>::infinity()};
+            }
+            if (db_linked && i < servers) {
+                init(db_link[i], db_link_t[i], t);
+            } else {
+                db_link_t[i] = {t, std::numeric_limits<double>::infinity()};
+            }
+        }
+    }
+
+    [[nodiscard]] double nextTime() const {
+        double t = std::min(gen_t.tn, bal_t.tn);
+        for (int i = 0; i < servers; i++) {
+            t = std::min({t, srv_t[i].tn, dispatch_link_t[i].tn, db_link_t[i].tn});
+        }
+        return std::min({t, db_t.tn, inj_t.tn, scaler_t.tn, stealer_t.tn, cache_t.tn});
+    }
+
+    template<typename T>
+    static void route(const Port<T>& from, const Port<T>& to) {
+        for (const auto& msg : from->getBag()) {
+            to->addMessage(msg);
+        }
+    }
+
+    template<typename M>
+    void transition(component<M>& model, slot& s, double t, bool has_input) {
+        bool imminent = (s.tn == t);
+        if (imminent && has_input) {
+            model.M::confluentTransition(model.getState(), t - s.tl);
+        } else if (imminent) {
+            model.M::internalTransition(model.getState());
+        } else if (has_input) {
+            model.M::externalTransition(model.getState(), t - s.tl);
+        } else {
+            return;
+        }
+        s.tl = t;
+        s.tn = t + model.M::timeAdvance(model.getState());
+        events++;
+    }
+
+    void step(double t) {
+
+        // output functions of the imminent components, followed by the couplings
+        if (gen_t.tn == t) {
+            gen.GEN::output(gen.getState());
+            route(gen.generator_out1, bal.balancer_in);
+        }
+        if (bal_t.tn == t) {
+            bal.BAL::output(bal.getState());
+            if (dispatch_linked) {
+                route(bal.balancer_out1, dispatch_link[0].wanlink_in);
+                route(bal.balancer_out2, dispatch_link[1].wanlink_in);
+                route(bal.balancer_out3, dispatch_link[2].wanlink_in);
+            } else {
+                route(bal.balancer_out1, srv[0].server_in);
+                route(bal.balancer_out2, srv[1].server_in);
+                route(bal.balancer_out3, srv[2].server_in);
+            }
+            for (int i = 0; hedging && i < servers; i++) {
+                route(bal.balancer_out_cancel, srv[i].server_in_cancel);
+                if (dispatch_linked) {
+                    route(bal.balancer_out_cancel, dispatch_link[i].wanlink_in_cancel);
+                }
+            }
+        }
+        for (int i = 0; i < servers; i++) {
+            if (srv_t[i].tn == t) {
+                srv[i].SRV::output(srv[i].getState());
+                jobs_out += srv[i].server_out1->getBag().size();
+                if (db_linked) {
+                    route(srv[i].server_out2, db_link[i].wanlink_in);
+                } else if (caching) {
+                    route(srv[i].server_out2, cache.dbcache_in);
+                } else {
+                    route(srv[i].server_out2, db.dbserver_in);
+                }
+                for (int j = 0; stealing && j < servers; j++) {
+                    if (j != i) {
+                        route(srv[i].server_out_stolen, srv[j].server_in_stolen);
+                    }
+                }
+            }
+        }
+        route(srv[0].server_out1, bal.balancer_in_done1);
+        route(srv[1].server_out1, bal.balancer_in_done2);
+        route(srv[2].server_out1, bal.balancer_in_done3);
+        if (hedging) {
+            route(srv[0].server_out_cancelled, bal.balancer_in_done1);
+            route(srv[1].server_out_cancelled, bal.balancer_in_done2);
+            route(srv[2].server_out_cancelled, bal.balancer_in_done3);
+        }
+        if (db_t.tn == t) {
+            db.DB::output(db.getState());
+            route(db.dbserver_out1, srv[0].server_in_db);
+            route(db.dbserver_out2, srv[1].server_in_db);
+            route(db.dbserver_out3, srv[2].server_in_db);
+        }
+        if (inj_t.tn == t) {
+            inj.FI::output(inj.getState());
+            std::array<Port<int>, MAX_SERVERS> inj_out = {inj.faultinjector_out1, inj.faultinjector_out2, inj.faultinjector_out3};
+            std::array<Port<int>, MAX_SERVERS> bal_health = {bal.balancer_in_health1, bal.balancer_in_health2, bal.balancer_in_health3};
+            for (int i = 0; i < servers; i++) {
+                route(inj_out[i], srv[i].server_in_ctrl);
+                route(inj_out[i], bal_health[i]);
+            }
+        }
+        if (scaler_t.tn == t) {
+            scaler.AS::output(scaler.getState());
+            route(scaler.autoscaler_out, bal.balancer_in_active);
+        }
+        if (scaling) {
+            route(bal.balancer_out1, scaler.autoscaler_in_dispatched1);
+            route(bal.balancer_out2, scaler.autoscaler_in_dispatched2);
+            route(bal.balancer_out3, scaler.autoscaler_in_dispatched3);
+            route(srv[0].server_out1, scaler.autoscaler_in_done1);
+            route(srv[1].server_out1, scaler.autoscaler_in_done2);
+            route(srv[2].server_out1, scaler.autoscaler_in_done3);
+            if (hedging) {
+                route(srv[0].server_out_cancelled, scaler.autoscaler_in_done1);
+                route(srv[1].server_out_cancelled, scaler.autoscaler_in_done2);
+                route(srv[2].server_out_cancelled, scaler.autoscaler_in_done3);
+            }
+        }
+        if (stealer_t.tn == t) {
+            stealer.WS::output(stealer.getState());
+            route(stealer.workstealer_out1, srv[0].server_in_steal);
+            route(stealer.workstealer_out2, srv[1].server_in_steal);
+            route(stealer.workstealer_out3, srv[2].server_in_steal);
+            route(stealer.workstealer_out_moves, bal.balancer_in_moves);
+        }
+        if (stealing) {
+            if (!dispatch_linked) {
+                route(bal.balancer_out1, stealer.workstealer_in_dispatched1);
+                route(bal.balancer_out2, stealer.workstealer_in_dispatched2);
+                route(bal.balancer_out3, stealer.workstealer_in_dispatched3);
+            }
+            route(srv[0].server_out1, stealer.workstealer_in_done1);
+            route(srv[1].server_out1, stealer.workstealer_in_done2);
+            route(srv[2].server_out1, stealer.workstealer_in_done3);
+            route(srv[0].server_out_refused, stealer.workstealer_in_refused1);
+            route(srv[1].server_out_refused, stealer.workstealer_in_refused2);
+            route(srv[2].server_out_refused, stealer.workstealer_in_refused3);
+            if (hedging) {
+                route(srv[0].server_out_cancelled, stealer.workstealer_in_done1);
+                route(srv[1].server_out_cancelled, stealer.workstealer_in_done2);
+                route(srv[2].server_out_cancelled, stealer.workstealer_in_done3);
+            }
+            if (faults) {
+                route(inj.faultinjector_out1, stealer.workstealer_in_health1);
+                route(inj.faultinjector_out2, stealer.workstealer_in_health2);
+                route(inj.faultinjector_out3, stealer.workstealer_in_health3);
+            }
+            if (scaling) {
+                route(scaler.autoscaler_out, stealer.workstealer_in_active);
+            }
+        }
+        if (cache_t.tn == t) {
+            cache.DC::output(cache.getState());
+            route(cache.dbcache_out_db, db.dbserver_in);
+            route(cache.dbcache_out1, srv[0].server_in_db);
+            route(cache.dbcache_out2, srv[1].server_in_db);
+            route(cache.dbcache_out3, srv[2].server_in_db);
+        }
+        for (int i = 0; i < servers; i++) {
+            if (dispatch_link_t[i].tn == t) {
+                dispatch_link[i].WL::output(dispatch_link[i].getState());
+                route(dispatch_link[i].wanlink_out, srv[i].server_in);
+                if (stealing) {
+                    std::array<Port<job>, MAX_SERVERS> stealer_dispatched = {stealer.workstealer_in_dispatched1, stealer.workstealer_in_dispatched2, stealer.workstealer_in_dispatched3};
+                    route(dispatch_link[i].wanlink_out, stealer_dispatched[i]);
+                }
+                if (hedging) {
+                    std::array<Port<job>, MAX_SERVERS> bal_done = {bal.balancer_in_done1, bal.balancer_in_done2, bal.balancer_in_done3};
+                    std::array<Port<job>, MAX_SERVERS> scaler_done = {scaler.autoscaler_in_done1, scaler.autoscaler_in_done2, scaler.autoscaler_in_done3};
+                    route(dispatch_link[i].wanlink_out_cancelled, bal_done[i]);
+                    if (scaling) {
+                        route(dispatch_link[i].wanlink_out_cancelled, scaler_done[i]);
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < servers; i++) {
+            if (db_link_t[i].tn == t) {
+                db_link[i].WL::output(db_link[i].getState());
+                route(db_link[i].wanlink_out, caching ? cache.dbcache_in : db.dbserver_in);
+            }
+        }
+
+        // state transitions
+        transition(gen, gen_t, t, false);
+        bool bal_input = !bal.balancer_in->getBag().empty() || !bal.balancer_in_done1->getBag().empty()
+            || !bal.balancer_in_done2->getBag().empty() || !bal.balancer_in_done3->getBag().empty()
+            || !bal.balancer_in_health1->getBag().empty() || !bal.balancer_in_health2->getBag().empty() || !bal.balancer_in_health3->getBag().empty()
+            || !bal.balancer_in_active->getBag().empty() || !bal.balancer_in_moves->getBag().empty();
+        transition(bal, bal_t, t, bal_input);
+        for (int i = 0; i < servers; i++) {
+            bool has_input = !srv[i].server_in->getBag().empty() || !srv[i].server_in_db->getBag().empty() || !srv[i].server_in_ctrl->getBag().empty()
+                || !srv[i].server_in_steal->getBag().empty() || !srv[i].server_in_stolen->getBag().empty() || !srv[i].server_in_cancel->getBag().empty();
+            transition(srv[i], srv_t[i], t, has_input);
+        }
+        transition(db, db_t, t, !db.dbserver_in->getBag().empty());
+        transition(inj, inj_t, t, false);
+        bool scaler_input = !scaler.autoscaler_in_dispatched1->getBag().empty() || !scaler.autoscaler_in_dispatched2->getBag().empty()
+            || !scaler.autoscaler_in_dispatched3->getBag().empty() || !scaler.autoscaler_in_done1->getBag().empty()
+            || !scaler.autoscaler_in_done2->getBag().empty() || !scaler.autoscaler_in_done3->getBag().empty();
+        transition(scaler, scaler_t, t, scaler_input);
+        bool stealer_input = !stealer.workstealer_in_dispatched1->getBag().empty() || !stealer.workstealer_in_dispatched2->getBag().empty()
+            || !stealer.workstealer_in_dispatched3->getBag().empty() || !stealer.workstealer_in_done1->getBag().empty()
+            || !stealer.workstealer_in_done2->getBag().empty() || !stealer.workstealer_in_done3->getBag().empty()
+            || !stealer.workstealer_in_health1->getBag().empty() || !stealer.workstealer_in_health2->getBag().empty()
+            || !stealer.workstealer_in_health3->getBag().empty() || !stealer.workstealer_in_active->getBag().empty()
+            || !stealer.workstealer_in_refused1->getBag().empty() || !stealer.workstealer_in_refused2->getBag().empty()
+            || !stealer.workstealer_in_refused3->getBag().empty();
+        transition(stealer, stealer_t, t, stealer_input);
+        transition(cache, cache_t, t, !cache.dbcache_in->getBag().empty());
+        for (int i = 0; i < servers; i++) {
+            transition(dispatch_link[i], dispatch_link_t[i], t, !dispatch_link[i].wanlink_in->getBag().empty() || !dispatch_link[i].wanlink_in_cancel->getBag().empty());
+        }
+        for (int i = 0; i < servers; i++) {
+            transition(db_link[i], db_link_t[i], t, !db_link[i].wanlink_in->getBag().empty());
+        }
+
+        // clear the bags for the next step
+        inj.faultinjector_out1->clear();
+        inj.faultinjector_out2->clear();
+        inj.faultinjector_out3->clear();
+        scaler.autoscaler_in_dispatched1->clear();
+        scaler.autoscaler_in_dispatched2->clear();
+        scaler.autoscaler_in_dispatched3->clear();
+        scaler.autoscaler_in_done1->clear();
+        scaler.autoscaler_in_done2->clear();
+        scaler.autoscaler_in_done3->clear();
+        scaler.autoscaler_out->clear();
+        stealer.workstealer_in_dispatched1->clear();
+        stealer.workstealer_in_dispatched2->clear();
+        stealer.workstealer_in_dispatched3->clear();
+        stealer.workstealer_in_done1->clear();
+        stealer.workstealer_in_done2->clear();
+        stealer.workstealer_in_done3->clear();
+        stealer.workstealer_in_health1->clear();
+        stealer.workstealer_in_health2->clear();
+        stealer.workstealer_in_health3->clear();
+        stealer.workstealer_in_active->clear();
+        stealer.workstealer_in_refused1->clear();
+        stealer.workstealer_in_refused2->clear();
+        stealer.workstealer_in_refused3->clear();
+        stealer.workstealer_out1->clear();
+        stealer.workstealer_out2->clear();
+        stealer.workstealer_out3->clear();
+        stealer.workstealer_out_moves->clear();
+        cache.dbcache_in->clear();
+        cache.dbcache_out_db->clear();
+        cache.dbcache_out1->clear();
+        cache.dbcache_out2->clear();
+        cache.dbcache_out3->clear();
+        for (int i = 0; i < MAX_SERVERS; i++) {
+            dispatch_link[i].wanlink_in->clear();
+            dispatch_link[i].wanlink_in_cancel->clear();
+            dispatch_link[i].wanlink_out->clear();
+            dispatch_link[i].wanlink_out_cancelled->clear();
+            db_link[i].wanlink_in->clear();
+            db_link[i].wanlink_out->clear();
+        }
+        gen.generator_out1->clear();
+        bal.balancer_in->clear();
+        bal.balancer_in_done1->clear();
+        bal.balancer_in_done2->clear();
+        bal.balancer_in_done3->clear();
+        bal.balancer_in_health1->clear();
+        bal.balancer_in_health2->clear();
+        bal.balancer_in_health3->clear();
+        bal.balancer_in_active->clear();
+        bal.balancer_in_moves->clear();
+        bal.balancer_out1->clear();
+        bal.balancer_out2->clear();
+        bal.balancer_out3->clear();
+        bal.balancer_out_cancel->clear();
+        for (auto& s : srv) {
+            s.server_in->clear();
+            s.server_in_db->clear();
+            s.server_in_ctrl->clear();
+            s.server_in_steal->clear();
+            s.server_in_stolen->clear();
+            s.server_out_stolen->clear();
+            s.server_out_refused->clear();
+            s.server_in_cancel->clear();
+            s.server_out_cancelled->clear();
+            s.server_out1->clear();
+            s.server_out2->clear();
+        }
+        db.dbserver_in->clear();
+        db.dbserver_out1->clear();
+        db.dbserver_out2->clear();
+        db.dbserver_out3->clear();
+    }
+};
+
+#endif
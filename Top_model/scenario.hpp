@@ -0,0 +1,455 @@
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "../utils/config.hpp"
+#include "top.hpp"
+
+// Everything run_scenario needs to run one experiment without recompiling
+struct scenarioConfig {
+    topConfig top;
+
+    double horizon = 3600.1;                    // simulated time at which the run stops
+    unsigned int seed = std::random_device{}(); // base seed of the random generators
+    bool flat = false;                          // run Flat_top instead of Top_coupled
+
+    std::string log_path = "simulation_results/scenario_log.txt";     // readable log of the models
+    std::string csv_path = "simulation_results/scenario_output.csv";  // Cadmium CSV logger, empty to disable
+    bool stdout_log = false;                                          // Cadmium logger on the standard output
+    bool bounded = false;                                             // bounded memory: capped model state, peak memory reported
+    metricsConfig metrics;                                            // live metrics endpoint, none by default
+
+    std::string restore_path;  // snapshot to resume from, empty to start at time 0
+    std::string save_path;     // snapshot written at the end of the run, empty for none
+};
+
+// Parses a fault schedule such as "600 crash 2, 900 recover 2" (time, crash/drain/recover, server id)
+inline bool parseFaultSchedule(const std::string& text, std::vector<faultEvent>& schedule) {
+    std::stringstream list(text);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        if (item.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+        std::istringstream fields(item);
+        faultEvent event{};
+        std::string action, rest;
+        if (!(fields >> event.time >> action >> event.server) || (fields >> rest)) {
+            return false;
+        }
+        if (action == "crash") {
+            event.status = serverStatus::down;
+        } else if (action == "drain") {
+            event.status = serverStatus::draining;
+        } else if (action == "recover") {
+            event.status = serverStatus::up;
+        } else {
+            return false;
+        }
+        schedule.push_back(event);
+    }
+    std::stable_sort(schedule.begin(), schedule.end(), [](const faultEvent& a, const faultEvent& b) { return a.time < b.time; });
+    return true;
+}
+
+// Reads the queue discipline and the class weights of the [servers] or [dbserver] section
+inline bool readQueueing(iniConfig& ini, const std::string& path, const std::string& section, queueConfig& queueing) {
+    bool ok = true;
+    std::string discipline = ini.getString(section, "discipline", disciplineName(queueing.discipline));
+    if (!parseDiscipline(discipline, queueing.discipline)) {
+        std::cerr << "Error: " << path << ": " << section << ".discipline must be fifo, strict_priority or weighted_fair" << std::endl;
+        ok = false;
+    }
+    std::vector<double> weights = ini.getDoubles(section, "class_weights", std::vector<double>(queueing.weights.begin(), queueing.weights.end()));
+    if (weights.empty() || weights.size() > queueing.weights.size() || std::any_of(weights.begin(), weights.end(), [](double w) { return w <= 0; })) {
+        std::cerr << "Error: " << path << ": " << section << ".class_weights needs 1 to " << job::MAX_CLASSES << " positive values" << std::endl;
+        ok = false;
+    } else {
+        std::copy(weights.begin(), weights.end(), queueing.weights.begin());
+    }
+    return ok;
+}
+
+// Reads a scenario file; keys that are missing keep their default value.
+// See main/scenarios/default.ini for every supported key.
+inline bool loadScenario(const std::string& path, scenarioConfig& scenario) {
+
+    iniConfig ini;
+    if (!ini.load(path)) {
+        return false;
+    }
+    bool ok = true;
+
+    // [simulation]
+    scenario.horizon = ini.getDouble("simulation", "horizon", scenario.horizon);
+    if (ini.has("simulation", "seed")) {
+        scenario.seed = static_cast<unsigned int>(ini.getInt("simulation", "seed", 0));
+    }
+    std::string engine = ini.getString("simulation", "engine", scenario.flat ? "flat" : "generic");
+    if (engine != "generic" && engine != "flat") {
+        std::cerr << "Error: " << path << ": simulation.engine must be generic or flat" << std::endl;
+        ok = false;
+    }
+    scenario.flat = (engine == "flat");
+
+    // [generator]
+    topConfig& top = scenario.top;
+    top.interarrival = ini.getDouble("generator", "interarrival", top.interarrival);
+    if (top.interarrival <= 0) {
+        std::cerr << "Error: " << path << ": generator.interarrival must be positive" << std::endl;
+        ok = false;
+    }
+    std::string arrival = ini.getString("generator", "distribution", distributionName(top.arrival_type));
+    if (!parseDistribution(arrival, top.arrival_type)) {
+        std::cerr << "Error: " << path << ": unknown generator.distribution " << arrival << std::endl;
+        ok = false;
+    }
+    std::vector<double> mix = ini.getDoubles("generator", "class_mix", std::vector<double>(top.class_mix.begin(), top.class_mix.end()));
+    if (mix.empty() || mix.size() > top.class_mix.size() || std::any_of(mix.begin(), mix.end(), [](double w) { return w < 0; })
+        || std::none_of(mix.begin(), mix.end(), [](double w) { return w > 0; })) {
+        std::cerr << "Error: " << path << ": generator.class_mix needs 1 to " << job::MAX_CLASSES << " non-negative values, one of them positive" << std::endl;
+        ok = false;
+    } else {
+        top.class_mix.fill(0.0);
+        std::copy(mix.begin(), mix.end(), top.class_mix.begin());
+    }
+    top.sessions = ini.getInt("generator", "sessions", top.sessions);
+    if (top.sessions < 0) {
+        std::cerr << "Error: " << path << ": generator.sessions must not be negative" << std::endl;
+        ok = false;
+    }
+    std::string trace = ini.getString("generator", "trace", "");
+    double speedup = ini.getDouble("generator", "trace_speedup", 1.0);
+    if (speedup <= 0) {
+        std::cerr << "Error: " << path << ": generator.trace_speedup must be positive" << std::endl;
+        ok = false;
+    } else if (!trace.empty() && !loadTrace(trace, speedup, top.trace)) {
+        ok = false;
+    }
+
+    // [balancer]
+    lbsConfig& lbs = top.lbs;
+    lbs.dispatch_time = ini.getDouble("balancer", "dispatch_time", lbs.dispatch_time);
+    lbs.dispatch_workers = ini.getInt("balancer", "workers", lbs.dispatch_workers);
+    if (lbs.dispatch_time < 0 || lbs.dispatch_workers < 1) {
+        std::cerr << "Error: " << path << ": balancer.dispatch_time must not be negative and balancer.workers must be positive" << std::endl;
+        ok = false;
+    }
+    std::string dispatch = ini.getString("balancer", "dispatch_distribution", distributionName(lbs.dispatch_type));
+    if (!parseDistribution(dispatch, lbs.dispatch_type)) {
+        std::cerr << "Error: " << path << ": unknown balancer.dispatch_distribution " << dispatch << std::endl;
+        ok = false;
+    }
+    std::string policy = ini.getString("balancer", "policy", policyName(lbs.policy));
+    if (!parsePolicy(policy, lbs.policy)) {
+        std::cerr << "Error: " << path << ": unknown balancer.policy " << policy << std::endl;
+        ok = false;
+    }
+    lbs.health_interval = ini.getDouble("balancer", "health_interval", lbs.health_interval);
+    if (lbs.health_interval < 0) {
+        std::cerr << "Error: " << path << ": balancer.health_interval must not be negative" << std::endl;
+        ok = false;
+    }
+    lbs.hash_replicas = ini.getInt("balancer", "hash_replicas", lbs.hash_replicas);
+    lbs.load_factor = ini.getDouble("balancer", "load_factor", lbs.load_factor);
+    if (lbs.hash_replicas < 1 || (lbs.load_factor != 0 && lbs.load_factor < 1)) {
+        std::cerr << "Error: " << path << ": balancer.hash_replicas must be positive and balancer.load_factor 0 or at least 1" << std::endl;
+        ok = false;
+    }
+
+    // [servers]
+    lbs.servers = ini.getInt("servers", "count", lbs.servers);
+    if (lbs.servers < 1 || lbs.servers > lbsConfig::MAX_SERVERS) {
+        std::cerr << "Error: " << path << ": servers.count must be between 1 and " << lbsConfig::MAX_SERVERS << std::endl;
+        ok = false;
+    }
+    std::vector<double> means = ini.getDoubles("servers", "mean", std::vector<double>(lbs.server_mean.begin(), lbs.server_mean.end()));
+    if (means.size() == 1) {
+        lbs.server_mean.fill(means[0]);
+    } else if (static_cast<int>(means.size()) >= lbs.servers && means.size() <= lbs.server_mean.size()) {
+        std::copy(means.begin(), means.end(), lbs.server_mean.begin());
+    } else {
+        std::cerr << "Error: " << path << ": servers.mean needs one value or one per server" << std::endl;
+        ok = false;
+    }
+    for (double mean : lbs.server_mean) {
+        if (mean <= 0) {
+            std::cerr << "Error: " << path << ": servers.mean must be positive" << std::endl;
+            ok = false;
+            break;
+        }
+    }
+    std::vector<double> speeds = ini.getDoubles("servers", "speed", std::vector<double>(lbs.server_speed.begin(), lbs.server_speed.end()));
+    if (speeds.size() == 1) {
+        lbs.server_speed.fill(speeds[0]);
+    } else if (static_cast<int>(speeds.size()) >= lbs.servers && speeds.size() <= lbs.server_speed.size()) {
+        std::copy(speeds.begin(), speeds.end(), lbs.server_speed.begin());
+    } else {
+        std::cerr << "Error: " << path << ": servers.speed needs one value or one per server" << std::endl;
+        ok = false;
+    }
+    for (double speed : lbs.server_speed) {
+        if (speed <= 0) {
+            std::cerr << "Error: " << path << ": servers.speed must be positive" << std::endl;
+            ok = false;
+            break;
+        }
+    }
+    std::string service = ini.getString("servers", "distribution", distributionName(lbs.service_type));
+    if (!parseDistribution(service, lbs.service_type)) {
+        std::cerr << "Error: " << path << ": unknown servers.distribution " << service << std::endl;
+        ok = false;
+    }
+    ok = readQueueing(ini, path, "servers", lbs.server_queueing) && ok;
+    lbs.server_cache.size = ini.getInt("servers", "cache_size", lbs.server_cache.size);
+    lbs.server_cache.hit_factor = ini.getDouble("servers", "cache_hit_factor", lbs.server_cache.hit_factor);
+    if (lbs.server_cache.size < 0 || lbs.server_cache.hit_factor <= 0 || lbs.server_cache.hit_factor > 1) {
+        std::cerr << "Error: " << path << ": servers.cache_size must not be negative and servers.cache_hit_factor must be in (0, 1]" << std::endl;
+        ok = false;
+    }
+
+    // [dbserver]
+    lbs.db_time = ini.getDouble("dbserver", "processing_time", lbs.db_time);
+    ok = readQueueing(ini, path, "dbserver", lbs.db_queueing) && ok;
+    batchConfig& batching = lbs.db_batching;
+    batching.max_size = ini.getInt("dbserver", "batch_size", batching.max_size);
+    batching.max_wait = ini.getDouble("dbserver", "batch_wait", batching.max_wait);
+    batching.overhead = ini.getDouble("dbserver", "batch_overhead", lbs.db_time);
+    batching.per_item = ini.getDouble("dbserver", "batch_item_time", batching.per_item);
+    if (batching.max_size < 1 || batching.max_wait < 0 || batching.overhead < 0 || batching.per_item < 0) {
+        std::cerr << "Error: " << path << ": dbserver.batch_size must be at least 1, batch_wait, batch_overhead and batch_item_time must not be negative" << std::endl;
+        ok = false;
+    }
+
+    // [faults]
+    faultConfig& faults = lbs.faults;
+    std::string schedule = ini.getString("faults", "schedule", "");
+    if (!parseFaultSchedule(schedule, faults.schedule)) {
+        std::cerr << "Error: " << path << ": faults.schedule must be a list of <time> crash|drain|recover <server>" << std::endl;
+        ok = false;
+    }
+    for (const auto& event : faults.schedule) {
+        if (event.time < 0 || event.server < 1 || event.server > lbs.servers) {
+            std::cerr << "Error: " << path << ": faults.schedule has an event at " << event.time << " for server " << event.server
+                      << ", times must not be negative and servers between 1 and " << lbs.servers << std::endl;
+            ok = false;
+            break;
+        }
+    }
+    faults.mtbf = ini.getDouble("faults", "mtbf", faults.mtbf);
+    faults.mttr = ini.getDouble("faults", "mttr", faults.mttr);
+    if (faults.mtbf < 0 || faults.mttr <= 0) {
+        std::cerr << "Error: " << path << ": faults.mtbf must not be negative and faults.mttr must be positive" << std::endl;
+        ok = false;
+    }
+    std::string outage = ini.getString("faults", "outage", "crash");
+    if (outage == "crash" || outage == "drain") {
+        faults.outage = (outage == "crash") ? serverStatus::down : serverStatus::draining;
+    } else {
+        std::cerr << "Error: " << path << ": faults.outage must be crash or drain" << std::endl;
+        ok = false;
+    }
+
+    // [autoscaler]
+    autoscalerConfig& scaling = lbs.autoscaling;
+    scaling.enabled = ini.getBool("autoscaler", "enabled", scaling.enabled);
+    scaling.min_servers = ini.getInt("autoscaler", "min_servers", scaling.min_servers);
+    scaling.initial_servers = ini.getInt("autoscaler", "initial_servers", scaling.initial_servers);
+    if (scaling.min_servers < 1 || scaling.min_servers > scaling.initial_servers || scaling.initial_servers > lbs.servers) {
+        std::cerr << "Error: " << path << ": autoscaler needs 1 <= min_servers <= initial_servers <= servers.count" << std::endl;
+        ok = false;
+    }
+    scaling.interval = ini.getDouble("autoscaler", "interval", scaling.interval);
+    if (scaling.interval <= 0) {
+        std::cerr << "Error: " << path << ": autoscaler.interval must be positive" << std::endl;
+        ok = false;
+    }
+    std::string signal = ini.getString("autoscaler", "signal", signalName(scaling.signal));
+    if (!parseSignal(signal, scaling.signal)) {
+        std::cerr << "Error: " << path << ": autoscaler.signal must be utilisation or queue_depth" << std::endl;
+        ok = false;
+    }
+    scaling.scale_up = ini.getDouble("autoscaler", "scale_up", scaling.scale_up);
+    scaling.scale_down = ini.getDouble("autoscaler", "scale_down", scaling.scale_down);
+    if (scaling.scale_down >= scaling.scale_up) {
+        std::cerr << "Error: " << path << ": autoscaler.scale_down must be below autoscaler.scale_up" << std::endl;
+        ok = false;
+    }
+    scaling.provision_delay = ini.getDouble("autoscaler", "provision_delay", scaling.provision_delay);
+    scaling.cooldown = ini.getDouble("autoscaler", "cooldown", scaling.cooldown);
+    if (scaling.provision_delay < 0 || scaling.cooldown < 0) {
+        std::cerr << "Error: " << path << ": autoscaler.provision_delay and autoscaler.cooldown must not be negative" << std::endl;
+        ok = false;
+    }
+
+    // [stealing]
+    stealConfig& stealing = lbs.stealing;
+    stealing.enabled = ini.getBool("stealing", "enabled", stealing.enabled);
+    stealing.cost = ini.getDouble("stealing", "cost", stealing.cost);
+    if (stealing.cost < 0) {
+        std::cerr << "Error: " << path << ": stealing.cost must not be negative" << std::endl;
+        ok = false;
+    }
+    stealing.threshold = ini.getInt("stealing", "threshold", stealing.threshold);
+    if (stealing.threshold < 2) {
+        std::cerr << "Error: " << path << ": stealing.threshold must be at least 2 (the job in service is never stolen)" << std::endl;
+        ok = false;
+    }
+
+    // [hedging]
+    hedgeConfig& hedging = lbs.hedging;
+    hedging.enabled = ini.getBool("hedging", "enabled", hedging.enabled);
+    hedging.delay = ini.getDouble("hedging", "delay", hedging.delay);
+    hedging.percentile = ini.getDouble("hedging", "percentile", hedging.percentile);
+    hedging.budget = ini.getDouble("hedging", "budget", hedging.budget);
+    if (hedging.delay < 0 || hedging.percentile < 0 || hedging.percentile >= 100 || hedging.budget < 0 || hedging.budget > 1) {
+        std::cerr << "Error: " << path << ": hedging needs delay >= 0, 0 <= percentile < 100 and 0 <= budget <= 1" << std::endl;
+        ok = false;
+    }
+
+    // [dbcache]
+    dbCacheConfig& cache = lbs.db_cache;
+    cache.enabled = ini.getBool("dbcache", "enabled", cache.enabled);
+    cache.capacity = ini.getInt("dbcache", "capacity", cache.capacity);
+    cache.keys = ini.getInt("dbcache", "keys", cache.keys);
+    cache.zipf = ini.getDouble("dbcache", "zipf", cache.zipf);
+    cache.hit_time = ini.getDouble("dbcache", "hit_time", cache.hit_time);
+    std::string eviction = ini.getString("dbcache", "eviction", evictionName(cache.eviction));
+    if (!parseEviction(eviction, cache.eviction)) {
+        std::cerr << "Error: " << path << ": unknown dbcache.eviction " << eviction << std::endl;
+        ok = false;
+    }
+    if (cache.capacity < 0 || cache.keys < 1 || cache.zipf < 0 || cache.hit_time < 0) {
+        std::cerr << "Error: " << path << ": dbcache needs capacity >= 0, keys >= 1, zipf >= 0 and hit_time >= 0" << std::endl;
+        ok = false;
+    }
+
+    // [network]: links on the balancer -> server and server -> db couplings
+    std::string network_type = ini.getString("network", "distribution", distributionName(lbs.dispatch_link.type));
+    if (!parseDistribution(network_type, lbs.dispatch_link.type)) {
+        std::cerr << "Error: " << path << ": unknown network.distribution " << network_type << std::endl;
+        ok = false;
+    }
+    lbs.dispatch_link.latency = ini.getDouble("network", "dispatch_latency", lbs.dispatch_link.latency);
+    lbs.dispatch_link.bandwidth = ini.getDouble("network", "bandwidth", lbs.dispatch_link.bandwidth);
+    lbs.dispatch_link.capacity = ini.getInt("network", "capacity", lbs.dispatch_link.capacity);
+    std::vector<double> sizes = ini.getDoubles("network", "job_size", std::vector<double>(lbs.dispatch_link.size.begin(), lbs.dispatch_link.size.end()));
+    if (sizes.size() == 1) {
+        lbs.dispatch_link.size.fill(sizes[0]);
+    } else if (!sizes.empty() && sizes.size() <= lbs.dispatch_link.size.size()) {
+        std::copy(sizes.begin(), sizes.end(), lbs.dispatch_link.size.begin());
+    } else {
+        std::cerr << "Error: " << path << ": network.job_size needs one value or one per class (up to " << job::MAX_CLASSES << ")" << std::endl;
+        ok = false;
+    }
+    if (lbs.dispatch_link.latency < 0 || lbs.dispatch_link.bandwidth < 0 || lbs.dispatch_link.capacity < 0
+        || std::any_of(lbs.dispatch_link.size.begin(), lbs.dispatch_link.size.end(), [](double s) { return s < 0; })) {
+        std::cerr << "Error: " << path << ": network latencies, bandwidth, capacity and job_size must not be negative" << std::endl;
+        ok = false;
+    }
+    // the db links share the distribution, bandwidth, capacity and job sizes, not the latency
+    lbs.db_link.type = lbs.dispatch_link.type;
+    lbs.db_link.bandwidth = lbs.dispatch_link.bandwidth;
+    lbs.db_link.capacity = lbs.dispatch_link.capacity;
+    lbs.db_link.size = lbs.dispatch_link.size;
+    lbs.db_link.latency = ini.getDouble("network", "db_latency", lbs.db_link.latency);
+    if (lbs.db_link.latency < 0) {
+        std::cerr << "Error: " << path << ": network latencies, bandwidth, capacity and job_size must not be negative" << std::endl;
+        ok = false;
+    }
+
+    // [standin]: local process doing the processing of the servers
+    lbs.server_standin.host = ini.getString("standin", "host", lbs.server_standin.host);
+    lbs.server_standin.port = ini.getInt("standin", "port", lbs.server_standin.port);
+    lbs.server_standin.timeout = ini.getDouble("standin", "timeout", lbs.server_standin.timeout);
+    if (lbs.server_standin.port < 0 || lbs.server_standin.port > 65535 || lbs.server_standin.timeout <= 0) {
+        std::cerr << "Error: " << path << ": standin.port must be between 0 and 65535 and standin.timeout positive" << std::endl;
+        ok = false;
+    }
+
+    // [memory]: bounded state for very long runs
+    scenario.bounded = ini.getBool("memory", "bounded", scenario.bounded);
+    int max_jobs = ini.getInt("memory", "max_jobs", 10000);
+    int windows = ini.getInt("memory", "timeline_windows", 1440);
+    if (max_jobs < 1 || windows < 1) {
+        std::cerr << "Error: " << path << ": memory.max_jobs and memory.timeline_windows must be positive" << std::endl;
+        ok = false;
+    } else if (scenario.bounded) {
+        lbs.max_jobs = max_jobs;
+        lbs.timeline_windows = static_cast<std::size_t>(windows);
+    }
+
+    // [regions]: every zone runs the pool described above, its servers scaled by the speed of the zone
+    regionConfig& regions = top.regions;
+    regions.zones = ini.getInt("regions", "zones", regions.zones);
+    if (regions.zones < 0 || regions.zones > regionConfig::MAX_ZONES) {
+        std::cerr << "Error: " << path << ": regions.zones must be between 0 and " << regionConfig::MAX_ZONES << std::endl;
+        ok = false;
+        regions.zones = 0;
+    }
+    regions.dispatch_time = ini.getDouble("regions", "dispatch_time", regions.dispatch_time);
+    std::string global_policy = ini.getString("regions", "policy", policyName(regions.policy));
+    if (!parsePolicy(global_policy, regions.policy)) {
+        std::cerr << "Error: " << path << ": unknown regions.policy " << global_policy << std::endl;
+        ok = false;
+    }
+    std::vector<double> latencies = ini.getDoubles("regions", "latency", {0});
+    std::vector<double> zone_speeds = ini.getDoubles("regions", "speed", {1});
+    std::string link_type = ini.getString("regions", "latency_distribution", distributionName(distributionType::constant));
+    distributionType link_distribution = distributionType::constant;
+    if (!parseDistribution(link_type, link_distribution)) {
+        std::cerr << "Error: " << path << ": unknown regions.latency_distribution " << link_type << std::endl;
+        ok = false;
+    }
+    bool per_zone = (latencies.size() == 1 || static_cast<int>(latencies.size()) == regions.zones)
+                 && (zone_speeds.size() == 1 || static_cast<int>(zone_speeds.size()) == regions.zones);
+    if (regions.enabled() && !per_zone) {
+        std::cerr << "Error: " << path << ": regions.latency and regions.speed need one value or one per zone" << std::endl;
+        ok = false;
+    }
+    for (int z = 0; per_zone && z < regions.zones; z++) {
+        double latency = latencies[latencies.size() == 1 ? 0 : z];
+        double speed = zone_speeds[zone_speeds.size() == 1 ? 0 : z];
+        if (latency < 0 || speed <= 0) {
+            std::cerr << "Error: " << path << ": regions.latency must not be negative and regions.speed must be positive" << std::endl;
+            ok = false;
+            break;
+        }
+        regions.link[z] = linkConfig{latency, link_distribution};
+        regions.lbs[z] = lbs;
+        for (double& s : regions.lbs[z].server_speed) {
+            s *= speed;
+        }
+    }
+    if (regions.enabled() && scenario.flat) {
+        std::cerr << "Error: " << path << ": regions need simulation.engine = generic, the flat model has a single pool" << std::endl;
+        ok = false;
+    }
+
+    // [output]
+    scenario.log_path = ini.getString("output", "log", scenario.log_path);
+    scenario.csv_path = ini.getString("output", "csv", scenario.csv_path);
+    scenario.stdout_log = ini.getBool("output", "stdout", scenario.stdout_log);
+
+    // [metrics]
+    scenario.metrics.port = ini.getInt("metrics", "port", scenario.metrics.port);
+    scenario.metrics.period = ini.getDouble("metrics", "period", scenario.metrics.period);
+    if (scenario.metrics.port < 0 || scenario.metrics.port > 65535 || scenario.metrics.period <= 0) {
+        std::cerr << "Error: " << path << ": metrics.port must be between 0 and 65535 and metrics.period positive" << std::endl;
+        ok = false;
+    }
+
+    // [checkpoint]
+    scenario.restore_path = ini.getString("checkpoint", "restore", scenario.restore_path);
+    scenario.save_path = ini.getString("checkpoint", "save", scenario.save_path);
+
+    ini.checkUnused();
+    return ok && ini.valid();
+}
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef SEARCH_HPP
+#define SEARCH_HPP
+
+#include <cmath>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include "scenario.hpp"
+
+// One configuration of the pool tried by the capacity search
+struct searchCandidate {
+    balancerPolicy policy;
+    double dispatch_time;
+    int workers;
+    int servers;
+    int db_batch;               // jobs per DB round trip
+    double cost = 0;
+    std::vector<double> p99{};  // server latency p99 of each replication, in replication order
+    int backlogged = 0;         // replications that ended with more than max_backlog jobs at the balancer
+};
+
+// Outcome of one replication of a candidate
+struct searchRun {
+    double p99;    // server latency p99
+    int backlog;   // jobs waiting for or in dispatch at the end
+};
+
+// Capacity search: candidate values of each balancer and pool parameter (a missing key
+// keeps the value of the scenario), cost of the resources, p99 target and stopping rules
+struct searchConfig {
+    static constexpr unsigned int SEED_STRIDE = 100;  // replication r runs with the scenario seed + r * SEED_STRIDE
+
+    std::string scenario_path;
+    double target = 1;                   // server latency p99 to meet, in seconds
+    std::vector<balancerPolicy> policies;
+    std::vector<double> dispatch_times;
+    std::vector<int> workers;
+    std::vector<int> servers;
+    std::vector<int> db_batches;
+    double server_cost = 1;              // per server
+    double worker_cost = 0;              // per dispatch worker
+    double dispatch_cost = 0;            // per job/s of dispatch capacity (workers / dispatch_time)
+    double batch_cost = 0;               // per job of DB batch size
+    int replications = 3;                // replications added to an undecided candidate per round
+    int max_replications = 15;           // a candidate still undecided after these is not selected
+    int max_backlog = 100;               // jobs left at the balancer above which a run misses the target
+    int threads = 0;                     // runs in parallel, 0 for one per hardware thread
+    bool sensitivity = true;             // one-at-a-time sensitivity of the p99 around the selection
+};
+
+enum class searchVerdict { undecided, meets, misses };
+
+inline const char* verdictName(searchVerdict verdict) {
+    switch (verdict) {
+        case searchVerdict::meets: return "meets the target";
+        case searchVerdict::misses: return "misses the target";
+        default: return "undecided";
+    }
+}
+
+// two-sided 95% quantile of Student's t distribution with df degrees of freedom
+inline double studentT95(std::size_t df) {
+    static constexpr double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+                                       2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    return df == 0 ? INFINITY : df <= 30 ? table[df - 1] : 1.96;
+}
+
+// mean of the p99 of a candidate and the half-width of its 95% confidence interval
+inline std::pair<double, double> p99Interval(const searchCandidate& c) {
+    double n = static_cast<double>(c.p99.size());
+    double mean = 0.0;
+    for (double x : c.p99) {
+        mean += x / n;
+    }
+    double square = 0.0;
+    for (double x : c.p99) {
+        square += (x - mean) * (x - mean);
+    }
+    double sd = c.p99.size() > 1 ? std::sqrt(square / (n - 1)) : INFINITY;
+    return {mean, studentT95(c.p99.size() - 1) * sd / std::sqrt(n)};
+}
+
+// a candidate meets (misses) the target once its whole confidence interval is below (above) it.
+// The server latency starts at the server, so a balancer that cannot keep up is caught by
+// its backlog: a candidate with a backlogged replication misses the target.
+inline searchVerdict judge(const searchCandidate& c, double target) {
+    if (c.backlogged > 0) {
+        return searchVerdict::misses;
+    }
+    auto [mean, half_width] = p99Interval(c);
+    if (c.p99.size() > 1 && mean + half_width <= target) {
+        return searchVerdict::meets;
+    }
+    if (c.p99.size() > 1 && mean - half_width > target) {
+        return searchVerdict::misses;
+    }
+    return searchVerdict::undecided;
+}
+
+inline double candidateCost(const searchConfig& search, const searchCandidate& c) {
+    return search.server_cost * c.servers + search.worker_cost * c.workers
+         + (c.dispatch_time > 0 ? search.dispatch_cost * c.workers / c.dispatch_time : 0.0) + search.batch_cost * c.db_batch;
+}
+
+// every combination of the candidate values, cheapest first
+inline std::vector<searchCandidate> enumerateCandidates(const searchConfig& search) {
+    std::vector<searchCandidate> list;
+    for (int n : search.servers) {
+        for (auto policy : search.policies) {
+            for (double d : search.dispatch_times) {
+                for (int w : search.workers) {
+                    for (int b : search.db_batches) {
+                        searchCandidate c{.policy = policy, .dispatch_time = d, .workers = w, .servers = n, .db_batch = b};
+                        c.cost = candidateCost(search, c);
+                        list.push_back(c);
+                    }
+                }
+            }
+        }
+    }
+    std::stable_sort(list.begin(), list.end(), [](const searchCandidate& a, const searchCandidate& b) { return a.cost < b.cost; });
+    return list;
+}
+
+// the scenario's model with the parameters of a candidate
+inline topConfig configure(const topConfig& base, const searchCandidate& c) {
+    topConfig config = base;
+    lbsConfig& lbs = config.lbs;
+    lbs.policy = c.policy;
+    lbs.dispatch_time = c.dispatch_time;
+    lbs.dispatch_workers = c.workers;
+    lbs.servers = c.servers;
+    lbs.autoscaling.initial_servers = std::min(lbs.autoscaling.initial_servers, c.servers);
+    lbs.autoscaling.min_servers = std::min(lbs.autoscaling.min_servers, c.servers);
+    lbs.db_batching.max_size = c.db_batch;
+    return config;
+}
+
+inline void printCandidate(std::ostream& os, const searchCandidate& c) {
+    os << "servers " << c.servers << ", " << policyName(c.policy) << ", dispatch " << c.dispatch_time << " s x " << c.workers
+       << (c.workers == 1 ? " worker" : " workers") << ", db batch " << c.db_batch << " (cost " << c.cost << ")";
+}
+
+inline void printResult(std::ostream& os, const searchCandidate& c, double target) {
+    auto [mean, half_width] = p99Interval(c);
+    os << "p99 " << mean << " s +/- " << half_width << " over " << c.p99.size() << " runs, ";
+    if (c.backlogged > 0) {
+        os << "backlogged runs " << c.backlogged << ", ";
+    }
+    os << verdictName(judge(c, target));
+}
+
+// Reads a search file: a [search] section naming the scenario to start from
+// (see main/scenarios/capacity_search.ini for every key)
+inline bool loadSearch(const std::string& path, searchConfig& search, scenarioConfig& scenario) {
+
+    iniConfig ini;
+    if (!ini.load(path)) {
+        return false;
+    }
+    bool ok = true;
+    search.scenario_path = ini.getString("search", "scenario", "");
+    if (search.scenario_path.empty()) {
+        std::cerr << "Error: " << path << ": search.scenario must name the scenario file to start from" << std::endl;
+        return false;
+    }
+    if (!loadScenario(search.scenario_path, scenario)) {
+        return false;
+    }
+    if (scenario.top.regions.enabled()) {
+        std::cerr << "Error: " << path << ": the search covers a single pool, not regions" << std::endl;
+        ok = false;
+    }
+    const lbsConfig& lbs = scenario.top.lbs;
+
+    search.target = ini.getDouble("search", "p99_target", search.target);
+    for (const auto& name : ini.getStrings("search", "policy", {policyName(lbs.policy)})) {
+        balancerPolicy policy = balancerPolicy::modulo;
+        if (!parsePolicy(name, policy)) {
+            std::cerr << "Error: " << path << ": unknown policy " << name << " in search.policy" << std::endl;
+            ok = false;
+        }
+        search.policies.push_back(policy);
+    }
+    search.dispatch_times = ini.getDoubles("search", "dispatch_time", {lbs.dispatch_time});
+    auto integers = [&ini](const char* key, int value) {
+        std::vector<int> list;
+        for (double x : ini.getDoubles("search", key, {static_cast<double>(value)})) {
+            list.push_back(static_cast<int>(std::lround(x)));
+        }
+        return list;
+    };
+    search.workers = integers("workers", lbs.dispatch_workers);
+    search.servers = integers("servers", lbs.servers);
+    search.db_batches = integers("db_batch", lbs.db_batching.max_size);
+    auto positive = [](const auto& list) {
+        return !list.empty() && std::all_of(list.begin(), list.end(), [](auto x) { return x > 0; });
+    };
+    bool dispatch_ok = !search.dispatch_times.empty() && std::all_of(search.dispatch_times.begin(), search.dispatch_times.end(), [](double d) { return d >= 0; });
+    if (!dispatch_ok || !positive(search.workers) || !positive(search.db_batches) || !positive(search.servers)
+        || std::any_of(search.servers.begin(), search.servers.end(), [](int n) { return n > lbsConfig::MAX_SERVERS; })) {
+        std::cerr << "Error: " << path << ": search.dispatch_time must not be negative, search.workers and db_batch must be positive, search.servers between 1 and "
+                  << lbsConfig::MAX_SERVERS << std::endl;
+        ok = false;
+    }
+
+    search.server_cost = ini.getDouble("search", "server_cost", search.server_cost);
+    search.worker_cost = ini.getDouble("search", "worker_cost", search.worker_cost);
+    search.dispatch_cost = ini.getDouble("search", "dispatch_cost", search.dispatch_cost);
+    search.batch_cost = ini.getDouble("search", "batch_cost", search.batch_cost);
+    search.replications = ini.getInt("search", "replications", search.replications);
+    search.max_replications = ini.getInt("search", "max_replications", search.max_replications);
+    search.max_backlog = ini.getInt("search", "max_backlog", search.max_backlog);
+    search.threads = ini.getInt("search", "threads", search.threads);
+    search.sensitivity = ini.getBool("search", "sensitivity", search.sensitivity);
+    if (search.target <= 0 || search.replications < 2 || search.max_replications < search.replications || search.max_backlog < 0 || search.threads < 0) {
+        std::cerr << "Error: " << path << ": search needs p99_target > 0, replications >= 2, max_replications >= replications, max_backlog >= 0 and threads >= 0" << std::endl;
+        ok = false;
+    }
+
+    ini.checkUnused();
+    return ok && ini.valid();
+}
+
+// adds the outcome of a batch of (candidate index, replication) pairs to the candidates
+inline void record(const searchConfig& search, std::vector<searchCandidate>& candidates, const std::vector<std::pair<std::size_t, int>>& tasks,
+                   const std::vector<searchRun>& runs) {
+    for (std::size_t t = 0; t < tasks.size(); t++) {
+        searchCandidate& c = candidates[tasks[t].first];
+        c.p99.push_back(runs[t].p99);
+        if (runs[t].backlog > search.max_backlog) {
+            c.backlogged++;
+        }
+    }
+}
+
+// Finds the cheapest candidate whose server latency p99 meets the target, by ranking and
+// selection over common random numbers: replication r of every candidate runs with the
+// same seed, so candidates are compared on the same arrivals and service times. Cost
+// levels are tried from the cheapest; every candidate of a level gets `replications`
+// runs, then more by rounds while its 95% confidence interval straddles the target, up to
+// `max_replications`. The first level with a candidate that meets the target ends the
+// search, and its candidate with the lowest mean p99 is selected. run(candidates, tasks)
+// runs a batch of (candidate index, replication) pairs, in parallel, and returns their
+// searchRun in order.
+// Returns the index of the selection in candidates, -1 if no candidate meets the target.
+template<typename RUN>
+int searchCheapest(const searchConfig& search, std::vector<searchCandidate>& candidates, RUN run, std::ostream& os) {
+    std::size_t level = 0;
+    while (level < candidates.size()) {
+        std::size_t end = level;
+        while (end < candidates.size() && candidates[end].cost == candidates[level].cost) {
+            end++;
+        }
+        while (true) {
+            std::vector<std::pair<std::size_t, int>> tasks;
+            for (std::size_t k = level; k < end; k++) {
+                const searchCandidate& c = candidates[k];
+                if (judge(c, search.target) == searchVerdict::undecided && static_cast<int>(c.p99.size()) < search.max_replications) {
+                    int first = static_cast<int>(c.p99.size());
+                    for (int r = first; r < std::min(first + search.replications, search.max_replications); r++) {
+                        tasks.emplace_back(k, r);
+                    }
+                }
+            }
+            if (tasks.empty()) {
+                break;
+            }
+            record(search, candidates, tasks, run(candidates, tasks));
+        }
+
+        int best = -1;
+        for (std::size_t k = level; k < end; k++) {
+            printCandidate(os, candidates[k]);
+            os << ": ";
+            printResult(os, candidates[k], search.target);
+            os << std::endl;
+            if (judge(candidates[k], search.target) == searchVerdict::meets
+                && (best < 0 || p99Interval(candidates[k]).first < p99Interval(candidates[best]).first)) {
+                best = static_cast<int>(k);
+            }
+        }
+        if (best >= 0) {
+            return best;
+        }
+        level = end;
+    }
+    return -1;
+}
+
+// One-at-a-time sensitivity of the p99 around a candidate: each parameter is moved
+// through its candidate values, the others kept, with the same replications
+template<typename RUN>
+void printSensitivity(const searchConfig& search, const searchCandidate& center, RUN run, std::ostream& os) {
+    auto [center_p99, center_half_width] = p99Interval(center);
+    auto vary = [&](const char* name, auto values, auto set, auto label) {
+        if (values.size() < 2) {
+            return;
+        }
+        std::vector<searchCandidate> moved;
+        std::vector<std::pair<std::size_t, int>> tasks;
+        for (const auto& value : values) {
+            searchCandidate c = center;
+            set(c, value);
+            c.p99.clear();
+            c.backlogged = 0;
+            c.cost = candidateCost(search, c);
+            for (int r = 0; r < static_cast<int>(center.p99.size()); r++) {
+                tasks.emplace_back(moved.size(), r);
+            }
+            moved.push_back(c);
+        }
+        record(search, moved, tasks, run(moved, tasks));
+        os << name << ":" << std::endl;
+        for (std::size_t k = 0; k < moved.size(); k++) {
+            auto [mean, half_width] = p99Interval(moved[k]);
+            os << "  " << label(moved[k]) << ": p99 " << mean << " s +/- " << half_width << " (" << (mean >= center_p99 ? "+" : "")
+               << mean - center_p99 << " s), cost " << moved[k].cost;
+            if (moved[k].backlogged > 0) {
+                os << ", backlogged runs " << moved[k].backlogged;
+            }
+            os << std::endl;
+        }
+    };
+    os << "sensitivity of the p99 around the selection (" << center_p99 << " s, same " << center.p99.size() << " replications):" << std::endl;
+    vary("servers", search.servers, [](searchCandidate& c, int n) { c.servers = n; }, [](const searchCandidate& c) { return std::to_string(c.servers); });
+    vary("policy", search.policies, [](searchCandidate& c, balancerPolicy p) { c.policy = p; }, [](const searchCandidate& c) { return std::string(policyName(c.policy)); });
+    vary("dispatch_time", search.dispatch_times, [](searchCandidate& c, double d) { c.dispatch_time = d; }, [](const searchCandidate& c) {
+        std::ostringstream ss;
+        ss << c.dispatch_time << " s";
+        return ss.str();
+    });
+    vary("workers", search.workers, [](searchCandidate& c, int w) { c.workers = w; }, [](const searchCandidate& c) { return std::to_string(c.workers); });
+    vary("db_batch", search.db_batches, [](searchCandidate& c, int b) { c.db_batch = b; }, [](const searchCandidate& c) { return std::to_string(c.db_batch); });
+}
+
+#endif
@@ -6,26 +6,112 @@
 #include "cadmium/modeling/devs/coupled.hpp"
 #include "../atomic_models/generator.hpp"
 #include "lbs.hpp"
+#include "glbs.hpp"
 
 using namespace cadmium;
 
+// Top parameters; the defaults are the original hard-coded values
+struct topConfig {
+    double interarrival = 0.3;                                  // mean time between two generated jobs
+    distributionType arrival_type = distributionType::constant;
+    std::array<double, job::MAX_CLASSES> class_mix = {1, 0, 0, 0};  // share of the generated jobs in each class
+    int sessions = 0;                                           // session keys drawn uniformly for the jobs, 0 for none
+    std::vector<traceRecord> trace;                             // captured requests replayed in place of the sampled arrivals, empty for none
+    lbsConfig lbs;
+    regionConfig regions;                                       // zones behind a global balancer, none by default (lbs alone)
+};
+
 struct Top_coupled: public Coupled {
- 
+
     std::shared_ptr<cadmium::PortInterface> out;
-    
-    Top_coupled(const std::string& id, const std::string& log_path = "simulation_results/top_log.txt") : Coupled(id) {
-
-           
-        out = addOutPort<int>("out");
-
-        auto gen = addComponent<generator>("generator", 0.3, log_path);  
-        auto lbs = addComponent<LBS>("LBS", log_path);              
-        
-        // external output coupling
-        addCoupling(lbs->out, out);
-        
-        // internal coupling
-        addCoupling(gen->generator_out1, lbs->in);
+
+    // components, kept to checkpoint their state
+    std::shared_ptr<generator> gen;
+    std::shared_ptr<LBS> lbs;    // single pool
+    std::shared_ptr<GLBS> glbs;  // only when zones are configured, in place of lbs
+
+    Top_coupled(const std::string& id, const std::string& log_path = "simulation_results/top_log.txt", unsigned int seed = std::random_device{}()) : Top_coupled(id, topConfig(), log_path, seed) { }
+
+    Top_coupled(const std::string& id, const topConfig& config, const std::string& log_path = "simulation_results/top_log.txt", unsigned int seed = std::random_device{}()) : Coupled(id) {
+
+
+        out = addOutPort<job>("out");
+
+        // the generator seed follows the server seeds (seed .. seed + servers - 1)
+        gen = addComponent<generator>("generator", config.interarrival, log_path, config.arrival_type, seed + lbsConfig::MAX_SERVERS, config.class_mix, config.sessions, config.trace);
+        if (config.regions.enabled()) {
+            glbs = addComponent<GLBS>("GLBS", config.regions, log_path, seed);
+            addCoupling(glbs->out, out);
+            addCoupling(gen->generator_out1, glbs->in);
+        } else {
+            lbs = addComponent<LBS>("LBS", config.lbs, log_path, seed);
+
+            // external output coupling
+            addCoupling(lbs->out, out);
+
+            // internal coupling
+            addCoupling(gen->generator_out1, lbs->in);
+        }
+    }
+
+    // live metrics of the model at simulation time t
+    [[nodiscard]] metricsSample sample(double t) const {
+        metricsSample m;
+        m.time = t;
+        m.generated = gen->jobsGenerated();
+        if (glbs) {
+            glbs->sample(m);
+        } else {
+            lbs->sample(m);
+        }
+        return m;
+    }
+
+    // summary of the run at simulation time t
+    void report(std::ostream& os, double t) const {
+        os << "generated jobs: " << gen->jobsGenerated() << std::endl;
+        if (glbs) {
+            glbs->report(os, t);
+        } else {
+            lbs->report(os, t);
+        }
+    }
+
+    // checkpoint: writes a snapshot of the whole model at simulation time t.
+    // Between two simulation steps every pending event is held in a component's state:
+    // the couplings are instantaneous, and the jobs in transit on a network or region
+    // link are in the queue of its wanlink model, which writes them with its state.
+    void save(std::ostream& os, double t) const {
+        snapshot::writeHeader(os, t);
+        gen->save(os, t);
+        snapshot::write(os, glbs != nullptr);
+        if (glbs) {
+            glbs->save(os, t);
+        } else {
+            lbs->save(os, t);
+        }
+    }
+
+    // checkpoint: restores a snapshot written by save(); t is set to its simulation time.
+    // The model must then be simulated by a root coordinator started at t.
+    bool restore(std::istream& is, double& t) {
+        if (!snapshot::readHeader(is, t)) {
+            return false;
+        }
+        bool regions = false;
+        if (!gen->restore(is, t) || !snapshot::read(is, regions)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        if (regions != (glbs != nullptr)) {
+            std::cerr << "Error: snapshot " << (regions ? "has" : "has no") << " zones, the model " << (glbs ? "has" : "has none") << std::endl;
+            return false;
+        }
+        if (glbs ? !glbs->restore(is, t) : !lbs->restore(is, t)) {
+            std::cerr << "Error: truncated or corrupted snapshot" << std::endl;
+            return false;
+        }
+        return true;
     }
 };
 
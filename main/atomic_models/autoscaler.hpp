@@ -0,0 +1,314 @@
+#ifndef AUTOSCALER_HPP
+#define AUTOSCALER_HPP
+
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/job.hpp"
+
+using namespace cadmium;
+
+// Load signal the autoscaler compares against its thresholds
+enum class autoscalerSignal {
+    utilisation,  // fraction of the interval the active servers had work, averaged over them
+    queue_depth   // time-averaged jobs in each active server (queued, processing or waiting for the DB)
+};
+
+inline const char* signalName(autoscalerSignal signal) {
+    return signal == autoscalerSignal::queue_depth ? "queue_depth" : "utilisation";
+}
+
+inline bool parseSignal(const std::string& name, autoscalerSignal& signal) {
+    if (name == "utilisation") {
+        signal = autoscalerSignal::utilisation;
+    } else if (name == "queue_depth") {
+        signal = autoscalerSignal::queue_depth;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct autoscalerConfig {
+    static constexpr int MAX_SERVERS = 3;  // pre-provisioned pool
+
+    bool enabled = false;
+    int min_servers = 1;           // never scales below
+    int initial_servers = 1;       // active when the simulation starts
+    double interval = 30;          // time between two decisions
+    autoscalerSignal signal = autoscalerSignal::utilisation;
+    double scale_up = 0.8;         // a server is added when the signal is above
+    double scale_down = 0.3;       // a server is removed when the signal is below
+    double provision_delay = 60;   // time for an added server to come into rotation
+    double cooldown = 120;         // no decision for this long after the pool changed
+};
+
+struct autoscalerState {
+
+    int active;             // servers in rotation: server 1 to active
+    bool provisioning;      // a server is being added
+    double tick_sigma;      // time to the next decision
+    double provision_sigma; // time to the end of the provisioning
+    double cooldown_left;   // time before the next decision is allowed
+
+    std::array<int, autoscalerConfig::MAX_SERVERS> depth;     // jobs dispatched to each server and not finished
+    std::array<double, autoscalerConfig::MAX_SERVERS> area;   // integral of depth since the last decision
+    std::array<double, autoscalerConfig::MAX_SERVERS> busy;   // time with depth > 0 since the last decision
+    double last_signal;
+
+    int scale_ups;
+    int scale_downs;
+    double server_seconds;  // integral of the active and provisioning servers: the cost of the pool
+    mutable double current_time;
+
+    explicit autoscalerState() : active(1), provisioning(false), tick_sigma(std::numeric_limits<double>::infinity()), provision_sigma(std::numeric_limits<double>::infinity()),
+        cooldown_left(0.0), depth{}, area{}, busy{}, last_signal(0.0), scale_ups(0), scale_downs(0), server_seconds(0.0), current_time(0.0) { }
+};
+
+#ifndef NO_LOGGING
+std::ostream& operator<<(std::ostream &out, const autoscalerState& state) {
+    out << "{active: " << state.active << ", provisioning: " << (state.provisioning ? "true" : "false")
+        << ", depth: [" << state.depth[0] << ", " << state.depth[1] << ", " << state.depth[2] << "], signal: " << state.last_signal << "}";
+    return out;
+}
+#endif
+
+// Adds and removes servers of a pre-provisioned pool from the observed load.
+// Queue depth and utilisation are counted from the jobs the balancer sends to
+// each server and the jobs the servers finish; every interval the mean signal of
+// the active servers is compared to the thresholds. The size of the active set
+// is sent to the balancer, which only routes to servers 1 to active. A removed
+// server finishes the jobs it already has.
+class autoscaler : public Atomic<autoscalerState> {
+    public:
+
+    // jobs sent to each server by the balancer
+    Port<job> autoscaler_in_dispatched1;
+    Port<job> autoscaler_in_dispatched2;
+    Port<job> autoscaler_in_dispatched3;
+
+    // jobs finished by each server
+    Port<job> autoscaler_in_done1;
+    Port<job> autoscaler_in_done2;
+    Port<job> autoscaler_in_done3;
+
+    // number of active servers
+    Port<int> autoscaler_out;
+
+    autoscalerConfig config;
+    int servers;
+
+    mutable std::ofstream log_file;
+
+    explicit autoscaler(const std::string& id, const autoscalerConfig& cfg, int n_servers = 3, const std::string& log_path = "simulation_results/autoscaler_log.txt")
+        : Atomic<autoscalerState>(id, autoscalerState()), config(cfg), servers(n_servers)
+    {
+        state.active = std::clamp(config.initial_servers, 1, servers);
+        state.tick_sigma = config.interval;
+
+        autoscaler_in_dispatched1 = addInPort<job>("autoscaler_in_dispatched1");
+        autoscaler_in_dispatched2 = addInPort<job>("autoscaler_in_dispatched2");
+        autoscaler_in_dispatched3 = addInPort<job>("autoscaler_in_dispatched3");
+        autoscaler_in_done1 = addInPort<job>("autoscaler_in_done1");
+        autoscaler_in_done2 = addInPort<job>("autoscaler_in_done2");
+        autoscaler_in_done3 = addInPort<job>("autoscaler_in_done3");
+
+        autoscaler_out = addOutPort<int>("autoscaler_out");
+
+        log_file.open(log_path, std::ios::app);
+        if (!log_file.is_open()) {
+            std::cerr << "Warning: Could not open log file: " << log_path << std::endl;
+        }
+    }
+
+    // mean signal of the active servers over the current interval, dt after the last event
+    [[nodiscard]] double signal(const autoscalerState& state, double dt) const {
+        double total = 0.0;
+        for (int i = 0; i < state.active; i++) {
+            if (config.signal == autoscalerSignal::queue_depth) {
+                total += state.area[i] + state.depth[i] * dt;
+            } else {
+                total += state.busy[i] + (state.depth[i] > 0 ? dt : 0.0);
+            }
+        }
+        return total / (config.interval * state.active);
+    }
+
+    // decision taken at a tick dt after the last event: +1 adds a server, -1 removes one
+    [[nodiscard]] int decide(const autoscalerState& state, double dt) const {
+        if (state.provisioning || state.cooldown_left - dt > 1e-9) {
+            return 0;
+        }
+        double value = signal(state, dt);
+        if (value > config.scale_up && state.active < servers) {
+            return 1;
+        }
+        if (value < config.scale_down && state.active > config.min_servers) {
+            return -1;
+        }
+        return 0;
+    }
+
+    // internal transition
+    void internalTransition(autoscalerState& state) const override {
+
+        double dt = nextEvent(state);
+        bool provisioned = (state.provision_sigma <= state.tick_sigma);
+        bool tick = (state.tick_sigma <= state.provision_sigma);
+        int decision = (tick && !provisioned) ? decide(state, dt) : 0;
+        double value = tick ? signal(state, dt) : state.last_signal;
+
+        advance(state, dt);
+
+        if (provisioned) {
+            state.active++;
+            state.provisioning = false;
+            state.provision_sigma = std::numeric_limits<double>::infinity();
+            state.cooldown_left = config.cooldown;
+            state.scale_ups++;
+        }
+
+        if (tick) {
+            if (decision > 0) {
+                state.provisioning = true;
+                state.provision_sigma = config.provision_delay;
+                std::cout << state.current_time << "\tAutoscaler provisions server " << state.active + 1 << ", " << signalName(config.signal) << " " << value << std::endl;
+                if (log_file.is_open()) {
+                    log_file << state.current_time << "\tAutoscaler provisions server " << state.active + 1 << ", " << signalName(config.signal) << " " << value << std::endl;
+                }
+            } else if (decision < 0) {
+                state.active--;
+                state.cooldown_left = config.cooldown;
+                state.scale_downs++;
+            }
+            state.last_signal = value;
+            state.area.fill(0.0);
+            state.busy.fill(0.0);
+            state.tick_sigma = config.interval;
+        }
+    }
+
+    // external transition
+    void externalTransition(autoscalerState& state, double e) const override {
+
+        state.current_time += e;
+        advance(state, e);
+
+        std::array<Port<job>, autoscalerConfig::MAX_SERVERS> dispatched = {autoscaler_in_dispatched1, autoscaler_in_dispatched2, autoscaler_in_dispatched3};
+        std::array<Port<job>, autoscalerConfig::MAX_SERVERS> done = {autoscaler_in_done1, autoscaler_in_done2, autoscaler_in_done3};
+        for (int i = 0; i < autoscalerConfig::MAX_SERVERS; i++) {
+            state.depth[i] += static_cast<int>(dispatched[i]->getBag().size());
+            state.depth[i] = std::max(0, state.depth[i] - static_cast<int>(done[i]->getBag().size()));
+        }
+    }
+
+    // output function
+    void output(const autoscalerState& state) const override {
+
+        double dt = nextEvent(state);
+        state.current_time += dt;
+
+        int active = state.active;
+        if (state.provision_sigma <= state.tick_sigma) {
+            active++;
+        } else if (decide(state, dt) < 0) {
+            active--;
+        } else {
+            return;
+        }
+
+        std::cout << state.current_time << "\tAutoscaler sets " << active << " active servers at autoscaler_out" << std::endl;
+        if (log_file.is_open()) {
+            log_file << state.current_time << "\tAutoscaler sets " << active << " active servers at autoscaler_out" << std::endl;
+        }
+        autoscaler_out->addMessage(active);
+    }
+
+    // checkpoint: writes the state as seen at simulation time t; the signals,
+    // the cost and the timers are accumulated up to t
+    void save(std::ostream& os, const autoscalerState& state, double t) const {
+        autoscalerState at_t = state;
+        advance(at_t, t - state.current_time);
+        snapshot::write(os, at_t.active);
+        snapshot::write(os, at_t.provisioning);
+        snapshot::write(os, at_t.tick_sigma);
+        snapshot::write(os, at_t.provision_sigma);
+        snapshot::write(os, at_t.cooldown_left);
+        snapshot::write(os, at_t.depth);
+        snapshot::write(os, at_t.area);
+        snapshot::write(os, at_t.busy);
+        snapshot::write(os, at_t.last_signal);
+        snapshot::write(os, at_t.scale_ups);
+        snapshot::write(os, at_t.scale_downs);
+        snapshot::write(os, at_t.server_seconds);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, autoscalerState& state, double t) const {
+        state.current_time = t;
+        return snapshot::read(is, state.active) && snapshot::read(is, state.provisioning)
+            && snapshot::read(is, state.tick_sigma) && snapshot::read(is, state.provision_sigma) && snapshot::read(is, state.cooldown_left)
+            && snapshot::read(is, state.depth) && snapshot::read(is, state.area) && snapshot::read(is, state.busy)
+            && snapshot::read(is, state.last_signal) && snapshot::read(is, state.scale_ups) && snapshot::read(is, state.scale_downs)
+            && snapshot::read(is, state.server_seconds);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
+    // summary of the scaling decisions and of the cost of the pool over [0, t]
+    void report(std::ostream& os, const autoscalerState& state, double t) const {
+        os << "autoscaler (" << signalName(config.signal) << "): active " << state.active << ", scale ups " << state.scale_ups
+           << ", scale downs " << state.scale_downs << ", server-seconds " << state.server_seconds
+           << ", mean active servers " << (t > 0 ? state.server_seconds / t : 0.0) << std::endl;
+    }
+
+    void report(std::ostream& os, double t) const {
+        report(os, state, t);
+    }
+
+    // time_advance function
+    [[nodiscard]] double timeAdvance(const autoscalerState& state) const override {
+        return nextEvent(state);
+    }
+
+    // destructor to close log file
+    ~autoscaler() {
+        if (log_file.is_open()) {
+            log_file.close();
+        }
+    }
+
+    private:
+
+    // time to the next decision or to the end of the provisioning
+    [[nodiscard]] static double nextEvent(const autoscalerState& state) {
+        return std::min(state.tick_sigma, state.provision_sigma);
+    }
+
+    // accumulates the signals and the cost over dt and moves the timers
+    static void advance(autoscalerState& state, double dt) {
+        for (int i = 0; i < autoscalerConfig::MAX_SERVERS; i++) {
+            state.area[i] += state.depth[i] * dt;
+            if (state.depth[i] > 0) {
+                state.busy[i] += dt;
+            }
+        }
+        state.server_seconds += (state.active + (state.provisioning ? 1 : 0)) * dt;
+        state.cooldown_left = std::max(0.0, state.cooldown_left - dt);
+        state.tick_sigma -= dt;
+        state.provision_sigma -= dt;
+    }
+};
+
+#endif
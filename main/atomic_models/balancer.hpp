@@ -4,24 +4,169 @@
 #include <iostream>
 #include <fstream>
 #include <queue>
+#include <array>
+#include <string>
 #include <limits>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <deque>
+#include <utility>
+#include <cstdint>
+#include <cmath>
+#include <random>
 #include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/job.hpp"
+#include "../utils/stats.hpp"
+#include "../utils/metrics.hpp"
+#include "../utils/distribution.hpp"
+#include "../utils/control.hpp"
 
 using namespace cadmium;
 
+// Dispatch policies of the balancer
+enum class balancerPolicy {
+    modulo,                 // job_id % servers
+    weighted_round_robin,   // smooth weighted round-robin over the server weights
+    weighted_least_loaded,  // fewest outstanding jobs per unit of weight
+    consistent_hash         // hash ring keyed by the job session, with optional bounded loads
+};
+
+inline const char* policyName(balancerPolicy policy) {
+    switch (policy) {
+        case balancerPolicy::weighted_round_robin: return "weighted_round_robin";
+        case balancerPolicy::weighted_least_loaded: return "weighted_least_loaded";
+        case balancerPolicy::consistent_hash: return "consistent_hash";
+        default: return "modulo";
+    }
+}
+
+inline bool parsePolicy(const std::string& name, balancerPolicy& policy) {
+    if (name == "modulo") {
+        policy = balancerPolicy::modulo;
+    } else if (name == "weighted_round_robin") {
+        policy = balancerPolicy::weighted_round_robin;
+    } else if (name == "weighted_least_loaded") {
+        policy = balancerPolicy::weighted_least_loaded;
+    } else if (name == "consistent_hash") {
+        policy = balancerPolicy::consistent_hash;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Request hedging: a job still unfinished `delay` after its dispatch is duplicated
+// to another server; the first copy to finish wins and the other one is cancelled
+struct hedgeConfig {
+    static constexpr unsigned long MIN_SAMPLES = 100;  // response times needed before the percentile replaces the delay
+
+    bool enabled = false;
+    double delay = 1;        // time after the dispatch before a job is duplicated
+    double percentile = 0;   // > 0: the delay is this percentile of the response times seen so far
+    double budget = 0.05;    // at most this fraction of the dispatched jobs is duplicated
+};
+
+struct balancerConfig {
+    static constexpr int MAX_SERVERS = 3;  // output ports of the balancer
+
+    double dispatch_time = 0.5;                           // mean time a worker spends dispatching a job
+    int servers = MAX_SERVERS;                          // servers connected to the output ports (1 to MAX_SERVERS)
+    balancerPolicy policy = balancerPolicy::modulo;
+    std::array<double, MAX_SERVERS> weights = {1, 1, 1};  // relative capacity of each server
+    double health_interval = 0;                           // period of the health checks, 0 to apply status reports at once
+    int active_servers = MAX_SERVERS;                     // servers 1 to active_servers are in the active set (autoscaling)
+    int hash_replicas = 64;                               // points of each server on the consistent hash ring, per unit of weight
+    double load_factor = 0;                               // consistent_hash bounded loads: at most load_factor times the mean load, 0 for no bound
+    hedgeConfig hedging{};                                // duplicates of slow jobs, disabled by default
+    int workers = 1;                                      // jobs dispatched in parallel
+    distributionType dispatch_type = distributionType::constant;  // dispatch time of each job
+    int max_jobs = 0;                                     // jobs held at once (waiting, dispatching or outstanding), the others are shed; 0 for no limit
+};
+
+// 64-bit mix (splitmix64 finaliser) used to place servers and sessions on the hash ring
+inline std::uint64_t mixHash(std::uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// A dispatched job the balancer waits for (hedging)
+struct inFlightJob {
+    job item;
+    int server;         // 0 to servers - 1
+    double dispatched;
+    int hedge;          // server running the duplicate, -1 if none
+
+    void save(std::ostream& os) const {
+        item.save(os);
+        snapshot::write(os, server);
+        snapshot::write(os, dispatched);
+        snapshot::write(os, hedge);
+    }
+
+    bool restore(std::istream& is) {
+        return item.restore(is) && snapshot::read(is, server) && snapshot::read(is, dispatched) && snapshot::read(is, hedge);
+    }
+};
+
+// A job taken by a dispatch worker, sent to its server when its dispatch time is over
+struct dispatchSlot {
+    job item;
+    double sigma;  // time left
+
+    void save(std::ostream& os) const {
+        item.save(os);
+        snapshot::write(os, sigma);
+    }
+
+    bool restore(std::istream& is) {
+        return item.restore(is) && snapshot::read(is, sigma);
+    }
+};
+
 struct balancerState {
     
     bool phase;  // true = active, false = passive
-    std::queue<int> job_queue;
+    std::queue<job> job_queue;              // jobs waiting for a dispatch worker
+    std::vector<dispatchSlot> dispatching;  // jobs taken by the busy workers, in the order they were taken
     mutable double current_time;
-    double sigma;  
+    double sigma;                           // time to the next dispatch
+
+    std::array<double, balancerConfig::MAX_SERVERS> current_weight;  // smooth weighted round-robin counters
+    std::array<int, balancerConfig::MAX_SERVERS> outstanding;        // jobs sent to each server and not finished yet
+    std::array<int, balancerConfig::MAX_SERVERS> dispatched;         // jobs sent to each server
+
+    double probe_sigma;                                                  // time to the next health check
+    std::array<serverStatus, balancerConfig::MAX_SERVERS> reported;      // last status reported by each server
+    std::array<bool, balancerConfig::MAX_SERVERS> healthy;               // servers in rotation, as of the last health check
+    int redirected;  // jobs sent elsewhere because the server the policy chose was out of rotation
+    int rejected;    // jobs dropped because no server was in rotation
+    int active;      // servers 1 to active are in the active set
+
+    std::map<int, inFlightJob> in_flight;  // dispatched jobs not finished yet, by id (hedging)
+    std::deque<int> hedge_candidates;      // in-flight jobs not considered for a hedge yet, in dispatch order
+    double hedge_sigma;                    // time to the next hedge decision
+    std::vector<job> cancelling;           // hedged jobs finished by one copy, the other is cancelled at the next output
+    int hedges;                            // duplicates sent
+    int hedge_wins;                        // hedged jobs finished first by the duplicate
+    latencyStats response;                 // time from the dispatch to the first completion (hedging)
+    int max_queue;                         // most jobs waiting for a dispatch worker
+    int shed;                              // jobs refused on arrival because max_jobs were held
     
-    explicit balancerState() : phase(false), current_time(0.0), sigma(std::numeric_limits<double>::infinity()) { }
+    explicit balancerState() : phase(false), current_time(0.0), sigma(std::numeric_limits<double>::infinity()), current_weight{}, outstanding{}, dispatched{},
+        probe_sigma(std::numeric_limits<double>::infinity()), reported{}, healthy{true, true, true}, redirected(0), rejected(0), active(balancerConfig::MAX_SERVERS),
+        hedge_sigma(std::numeric_limits<double>::infinity()), hedges(0), hedge_wins(0), max_queue(0), shed(0) { }
 };
 
 #ifndef NO_LOGGING
 std::ostream& operator<<(std::ostream &out, const balancerState& state) {
-    out << "{phase: " << (state.phase ? "active" : "passive") << ", queue_size: " << state.job_queue.size() << "}";
+    out << "{phase: " << (state.phase ? "active" : "passive") << ", queue_size: " << state.job_queue.size() + state.dispatching.size()
+        << ", dispatched: [" << state.dispatched[0] << ", " << state.dispatched[1] << ", " << state.dispatched[2] << "]"
+        << ", outstanding: [" << state.outstanding[0] << ", " << state.outstanding[1] << ", " << state.outstanding[2] << "]"
+        << ", healthy: [" << state.healthy[0] << ", " << state.healthy[1] << ", " << state.healthy[2] << "], active: " << state.active << "}";
     return out;
 }
 #endif
@@ -30,20 +175,78 @@ class balancer : public Atomic<balancerState> {
     public:
     
     //declare ports
-    Port<int> balancer_in;
-    Port<int> balancer_out1;
-    Port<int> balancer_out2;
-    Port<int> balancer_out3;
+    Port<job> balancer_in;
+    Port<job> balancer_out1;
+    Port<job> balancer_out2;
+    Port<job> balancer_out3;
+
+    // jobs finished by each server (used to count outstanding jobs)
+    Port<job> balancer_in_done1;
+    Port<job> balancer_in_done2;
+    Port<job> balancer_in_done3;
+
+    // serverStatus of each server, as a health probe would read it
+    Port<int> balancer_in_health1;
+    Port<int> balancer_in_health2;
+    Port<int> balancer_in_health3;
+
+    // number of servers in the active set (sent by the autoscaler)
+    Port<int> balancer_in_active;
+
+    // jobs moved between servers by work stealing
+    Port<stealRequest> balancer_in_moves;
+
+    // hedged jobs finished by one copy: every server drops the other copy
+    Port<job> balancer_out_cancel;
     
-    // parameter: dispatch time
+    // parameters: dispatch time, workers dispatching in parallel and distribution of the dispatch time
     double dispatch_time;
+    int workers;
+    distributionType dispatch_type;
+
+    // parameter: jobs held at once before arrivals are shed (0 = no limit)
+    int max_jobs;
+
+    // parameter: number of servers connected to the output ports (1 to 3)
+    int servers;
+
+    // parameters: dispatch policy and server weights
+    balancerPolicy policy;
+    std::array<double, balancerConfig::MAX_SERVERS> weights;
+
+    // parameter: period of the health checks (0 = status reports are applied when received)
+    double health_interval;
+
+    // parameters: consistent hash ring (sorted points and their server) and load bound
+    std::vector<std::pair<std::uint64_t, int>> ring;
+    double load_factor;
+
+    // parameter: request hedging
+    hedgeConfig hedging;
     
 
     mutable std::ofstream log_file;
+    mutable std::mt19937 rng;                             // random number generator
+    mutable std::exponential_distribution<double> dist;   // dispatch time (exponential dispatch)
     
 
-    explicit balancer(const std::string& id, double disp_time = 0.5, const std::string& log_path = "simulation_results/balancer_log.txt") : Atomic<balancerState>(id, balancerState()), dispatch_time(disp_time)
+    explicit balancer(const std::string& id, double disp_time = 0.5, const std::string& log_path = "simulation_results/balancer_log.txt", int n_servers = 3) : balancer(id, balancerConfig{.dispatch_time = disp_time, .servers = n_servers}, log_path) { }
+
+    explicit balancer(const std::string& id, const balancerConfig& config, const std::string& log_path = "simulation_results/balancer_log.txt", unsigned int seed = std::random_device{}())
+        : Atomic<balancerState>(id, balancerState()), dispatch_time(config.dispatch_time), workers(std::max(1, config.workers)), dispatch_type(config.dispatch_type), max_jobs(config.max_jobs), servers(config.servers), policy(config.policy), weights(config.weights), health_interval(config.health_interval), load_factor(config.load_factor), hedging(config.hedging),
+          rng(seed), dist(config.dispatch_time > 0 ? 1.0 / config.dispatch_time : 1.0)
     {
+        if (policy == balancerPolicy::consistent_hash) {
+            for (int i = 0; i < servers; i++) {
+                int points = std::max(1, static_cast<int>(std::lround(config.hash_replicas * weights[i])));
+                for (int k = 0; k < points; k++) {
+                    ring.emplace_back(mixHash((static_cast<std::uint64_t>(i + 1) << 32) | static_cast<std::uint32_t>(k)), i);
+                }
+            }
+            std::sort(ring.begin(), ring.end());
+        }
+        state.probe_sigma = probePeriod();
+        state.active = std::clamp(config.active_servers, 1, servers);
         
         log_file.open(log_path, std::ios::app);
 
@@ -51,30 +254,324 @@ class balancer : public Atomic<balancerState> {
             std::cerr << "Warning: Could not open log file: " << log_path << std::endl;
         }
 
-        balancer_in = addInPort<int>("balancer_in");
+        balancer_in = addInPort<job>("balancer_in");
+        balancer_in_done1 = addInPort<job>("balancer_in_done1");
+        balancer_in_done2 = addInPort<job>("balancer_in_done2");
+        balancer_in_done3 = addInPort<job>("balancer_in_done3");
+        balancer_in_health1 = addInPort<int>("balancer_in_health1");
+        balancer_in_health2 = addInPort<int>("balancer_in_health2");
+        balancer_in_health3 = addInPort<int>("balancer_in_health3");
+        balancer_in_active = addInPort<int>("balancer_in_active");
+        balancer_in_moves = addInPort<stealRequest>("balancer_in_moves");
 
         
-        balancer_out1 = addOutPort<int>("balancer_out1");
-        balancer_out2 = addOutPort<int>("balancer_out2");
-        balancer_out3 = addOutPort<int>("balancer_out3");
+        balancer_out1 = addOutPort<job>("balancer_out1");
+        balancer_out2 = addOutPort<job>("balancer_out2");
+        balancer_out3 = addOutPort<job>("balancer_out3");
+        balancer_out_cancel = addOutPort<job>("balancer_out_cancel");
+    }
+
+    // server (0 to servers - 1) the policy picks among the allowed ones for the job, -1 if none is allowed
+    int pickServer(const balancerState& state, const job& item, const std::array<bool, balancerConfig::MAX_SERVERS>& allowed) const {
+
+        if (policy == balancerPolicy::weighted_round_robin) {
+            int best = -1;
+            for (int i = 0; i < servers; i++) {
+                if (allowed[i] && (best < 0 || state.current_weight[i] + weights[i] > state.current_weight[best] + weights[best])) {
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        if (policy == balancerPolicy::consistent_hash) {
+            return ringServer(state, item, allowed);
+        }
+
+        if (policy == balancerPolicy::weighted_least_loaded) {
+            int best = -1;
+            for (int i = 0; i < servers; i++) {
+                if (allowed[i] && (best < 0 || (state.outstanding[i] + 1) / weights[i] < (state.outstanding[best] + 1) / weights[best])) {
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        // modulo: the next allowed server after job_id % active
+        int first = item.id % state.active;
+        for (int k = 0; k < state.active; k++) {
+            if (allowed[(first + k) % state.active]) {
+                return (first + k) % state.active;
+            }
+        }
+        return -1;
+    }
+
+    // consistent hashing: first allowed server clockwise from the session of the job on the ring.
+    // With bounded loads, servers holding load_factor times their share of the outstanding jobs
+    // (new job included) are passed over, so a hot session spills to the next server of the ring.
+    int ringServer(const balancerState& state, const job& item, const std::array<bool, balancerConfig::MAX_SERVERS>& allowed) const {
+        double total_load = 1.0;
+        double total_weight = 0.0;
+        for (int i = 0; i < servers; i++) {
+            if (allowed[i]) {
+                total_load += state.outstanding[i];
+                total_weight += weights[i];
+            }
+        }
+        if (total_weight == 0.0) {
+            return -1;
+        }
+        auto key = mixHash(static_cast<std::uint64_t>(static_cast<std::uint32_t>(item.affinityKey())));
+        auto start = std::lower_bound(ring.begin(), ring.end(), std::make_pair(key, 0)) - ring.begin();
+        int fallback = -1;
+        for (std::size_t k = 0; k < ring.size(); k++) {
+            int i = ring[(start + k) % ring.size()].second;
+            if (!allowed[i]) {
+                continue;
+            }
+            if (load_factor <= 0 || state.outstanding[i] + 1 <= std::ceil(load_factor * total_load * weights[i] / total_weight)) {
+                return i;
+            }
+            if (fallback < 0) {
+                fallback = i;
+            }
+        }
+        return fallback;
+    }
+
+    // servers of the active set
+    [[nodiscard]] static std::array<bool, balancerConfig::MAX_SERVERS> activeSet(const balancerState& state) {
+        std::array<bool, balancerConfig::MAX_SERVERS> active{};
+        for (int i = 0; i < state.active; i++) {
+            active[i] = true;
+        }
+        return active;
+    }
+
+    // servers of the active set that passed the last health check
+    [[nodiscard]] static std::array<bool, balancerConfig::MAX_SERVERS> inRotation(const balancerState& state) {
+        std::array<bool, balancerConfig::MAX_SERVERS> rotation = activeSet(state);
+        for (int i = 0; i < balancerConfig::MAX_SERVERS; i++) {
+            rotation[i] = rotation[i] && state.healthy[i];
+        }
+        return rotation;
+    }
+
+    // server (0 to servers - 1) that receives the job, -1 if every server is out of rotation
+    int selectServer(const balancerState& state, const job& item) const {
+        return pickServer(state, item, inRotation(state));
+    }
+
+    // time a worker spends dispatching the next job
+    double dispatchTime() const {
+        if (dispatch_type == distributionType::exponential && dispatch_time > 0) {
+            return dist(rng);
+        }
+        return dispatch_time;
+    }
+
+    // jobs the balancer is responsible for: waiting, being dispatched, or sent and not finished yet
+    [[nodiscard]] int held(const balancerState& state) const {
+        int jobs = static_cast<int>(state.job_queue.size() + state.dispatching.size());
+        for (int i = 0; i < servers; i++) {
+            jobs += std::max(0, state.outstanding[i]);
+        }
+        return jobs;
+    }
+
+    // worker whose job is sent next: the least time left, the earliest taken among ties; -1 if every worker is idle
+    [[nodiscard]] static int nextSlot(const balancerState& state) {
+        int next = -1;
+        for (std::size_t k = 0; k < state.dispatching.size(); k++) {
+            if (next < 0 || state.dispatching[k].sigma < state.dispatching[next].sigma) {
+                next = static_cast<int>(k);
+            }
+        }
+        return next;
+    }
+
+    // idle workers take the jobs waiting in the queue; the next dispatch is the earliest one
+    void assignWorkers(balancerState& state) const {
+        while (!state.job_queue.empty() && static_cast<int>(state.dispatching.size()) < workers) {
+            state.dispatching.push_back({state.job_queue.front(), dispatchTime()});
+            state.job_queue.pop();
+        }
+        int next = nextSlot(state);
+        state.phase = (next >= 0);
+        state.sigma = state.phase ? state.dispatching[next].sigma : std::numeric_limits<double>::infinity();
+    }
+
+    // time between two health checks (none when reports are applied at once)
+    [[nodiscard]] double probePeriod() const {
+        return health_interval > 0 ? health_interval : std::numeric_limits<double>::infinity();
+    }
+
+    // time to the next dispatch, health check or hedge decision; cancellations go at once
+    [[nodiscard]] static double nextEvent(const balancerState& state) {
+        if (!state.cancelling.empty()) {
+            return 0.0;
+        }
+        return std::min({state.sigma, state.probe_sigma, state.hedge_sigma});
+    }
+
+    // time after the dispatch before a job is duplicated: the fixed delay, or the
+    // percentile of the response times once enough of them were seen
+    [[nodiscard]] double hedgeDelay(const balancerState& state) const {
+        if (hedging.percentile > 0 && state.response.getCount() >= hedgeConfig::MIN_SAMPLES) {
+            return state.response.quantile(hedging.percentile / 100.0);
+        }
+        return hedging.delay;
+    }
+
+    // drops the candidates that already finished and times the decision on the oldest one
+    void scheduleHedge(balancerState& state) const {
+        while (!state.hedge_candidates.empty() && state.in_flight.count(state.hedge_candidates.front()) == 0) {
+            state.hedge_candidates.pop_front();
+        }
+        if (state.hedge_candidates.empty()) {
+            state.hedge_sigma = std::numeric_limits<double>::infinity();
+        } else {
+            double due = state.in_flight.at(state.hedge_candidates.front()).dispatched + hedgeDelay(state);
+            state.hedge_sigma = std::max(0.0, due - state.current_time);
+        }
+    }
+
+    // forgets the copies held by server i, lost in a crash or sent to it while it was down:
+    // a job whose other copy is still out keeps that one, the others are no longer in flight
+    void forgetServer(balancerState& state, int i) const {
+        for (auto entry = state.in_flight.begin(); entry != state.in_flight.end();) {
+            if (entry->second.hedge == i) {
+                entry->second.hedge = -1;
+            }
+            if (entry->second.server == i) {
+                if (entry->second.hedge < 0) {
+                    entry = state.in_flight.erase(entry);
+                    continue;
+                }
+                entry->second.server = entry->second.hedge;
+                entry->second.hedge = -1;
+            }
+            ++entry;
+        }
+    }
+
+    // server (0 to servers - 1) receiving the duplicate of the oldest candidate: the least
+    // loaded other server in rotation; -1 when the budget is spent or no server is left
+    int hedgeTarget(const balancerState& state) const {
+        int jobs = 0;
+        for (int i = 0; i < servers; i++) {
+            jobs += state.dispatched[i];
+        }
+        if (state.hedges + 1 > hedging.budget * jobs) {
+            return -1;
+        }
+        const inFlightJob& entry = state.in_flight.at(state.hedge_candidates.front());
+        auto rotation = inRotation(state);
+        rotation[entry.server] = false;
+        int best = -1;
+        for (int i = 0; i < servers; i++) {
+            if (rotation[i] && (best < 0 || (state.outstanding[i] + 1) / weights[i] < (state.outstanding[best] + 1) / weights[best])) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // health check: servers reported up are put back in rotation, the others are taken out
+    void checkHealth(balancerState& state) const {
+        for (int i = 0; i < servers; i++) {
+            bool up = (state.reported[i] == serverStatus::up);
+            if (up != state.healthy[i]) {
+                std::cout << state.current_time << "\tBalancer health check: server " << i + 1 << (up ? " back in rotation" : " out of rotation") << std::endl;
+                if (log_file.is_open()) {
+                    log_file << state.current_time << "\tBalancer health check: server " << i + 1 << (up ? " back in rotation" : " out of rotation") << std::endl;
+                }
+            }
+            state.healthy[i] = up;
+        }
     }
     
     // internal transition
     void internalTransition(balancerState& state) const override {
 
+        double elapsed = nextEvent(state);
+        bool dispatch = (state.sigma <= elapsed);
+        bool hedge = (state.hedge_sigma <= elapsed);
+        state.cancelling.clear();
 
-        if (!state.job_queue.empty()) {
-            state.job_queue.pop();
+        // the job and its duplicate go where output() sent them: both targets are chosen on the
+        // state output() saw, before the hedge, the health check or the dispatch change it
+        int sent = dispatch ? nextSlot(state) : -1;
+        int target = -1;
+        bool redirected = false;
+        auto rotation = inRotation(state);
+        if (sent >= 0) {
+            const job& next = state.dispatching[sent].item;
+            target = selectServer(state, next);
+            redirected = (target >= 0 && target != pickServer(state, next, activeSet(state)));
+        }
+
+        if (hedge) {
+            int copy_target = hedgeTarget(state);
+            if (copy_target >= 0) {
+                state.in_flight.at(state.hedge_candidates.front()).hedge = copy_target;
+                state.outstanding[copy_target]++;
+                state.hedges++;
+            }
+            state.hedge_candidates.pop_front();
+        }
+
+        if (state.probe_sigma <= elapsed) {
+            checkHealth(state);
+            state.probe_sigma = probePeriod();
+        } else {
+            state.probe_sigma -= elapsed;
+        }
+
+        for (auto& slot : state.dispatching) {
+            slot.sigma -= elapsed;
+        }
+
+        if (sent < 0) {
+            state.sigma -= elapsed;
+            if (hedging.enabled) {
+                scheduleHedge(state);
+            }
+            return;
         }
-        
-        if (!state.job_queue.empty()) {
 
-            state.phase = true;
-            state.sigma = dispatch_time;  
+        const job next = state.dispatching[sent].item;
+        state.dispatching.erase(state.dispatching.begin() + sent);
+
+        if (target < 0) {
+            state.rejected++;
         } else {
+            if (redirected) {
+                state.redirected++;
+            }
+            if (policy == balancerPolicy::weighted_round_robin) {
+                double total = 0.0;
+                for (int i = 0; i < servers; i++) {
+                    if (rotation[i]) {
+                        state.current_weight[i] += weights[i];
+                        total += weights[i];
+                    }
+                }
+                state.current_weight[target] -= total;
+            }
+            state.outstanding[target]++;
+            state.dispatched[target]++;
+            if (hedging.enabled) {
+                state.in_flight[next.id] = inFlightJob{next, target, state.current_time, -1};
+                state.hedge_candidates.push_back(next.id);
+            }
+        }
 
-            state.phase = false;  
-            state.sigma = std::numeric_limits<double>::infinity();
+        assignWorkers(state);
+        if (hedging.enabled) {
+            scheduleHedge(state);
         }
     }
 
@@ -86,23 +583,80 @@ class balancer : public Atomic<balancerState> {
         if (state.phase) {
             state.sigma -= e;  
         }
+        for (auto& slot : state.dispatching) {
+            slot.sigma -= e;
+        }
+        state.probe_sigma -= e;
+        state.hedge_sigma -= e;
         
+        std::array<Port<job>, balancerConfig::MAX_SERVERS> done = {balancer_in_done1, balancer_in_done2, balancer_in_done3};
+        for (int i = 0; i < balancerConfig::MAX_SERVERS; i++) {
+            state.outstanding[i] -= static_cast<int>(done[i]->getBag().size());
+            for (const auto& msg : done[i]->getBag()) {
+                auto entry = state.in_flight.find(msg.id);
+                if (entry == state.in_flight.end()) {
+                    continue;  // not tracked, or the cancelled copy of a hedged job
+                }
+                state.response.add(state.current_time - entry->second.dispatched);
+                if (entry->second.hedge >= 0) {
+                    state.cancelling.push_back(msg);
+                    if (entry->second.hedge == i) {
+                        state.hedge_wins++;
+                    }
+                }
+                state.in_flight.erase(entry);
+            }
+        }
+
+        std::array<Port<int>, balancerConfig::MAX_SERVERS> health = {balancer_in_health1, balancer_in_health2, balancer_in_health3};
+        for (int i = 0; i < balancerConfig::MAX_SERVERS; i++) {
+            for (const auto& msg : health[i]->getBag()) {
+                auto status = static_cast<serverStatus>(msg);
+                if (status == serverStatus::down || state.reported[i] == serverStatus::down) {
+                    state.outstanding[i] = 0;  // the jobs of a crashed server, or sent to it while down, never finish
+                    forgetServer(state, i);
+                }
+                state.reported[i] = status;
+            }
+        }
+        if (health_interval <= 0) {
+            checkHealth(state);
+        }
+
+        for (const auto& msg : balancer_in_moves->getBag()) {
+            state.outstanding[msg.victim - 1]--;
+            state.outstanding[msg.thief - 1]++;
+        }
+
+        for (const auto& msg : balancer_in_active->getBag()) {
+            state.active = std::clamp(msg, 1, servers);
+            std::cout << state.current_time << "\tBalancer routes to servers 1 to " << state.active << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tBalancer routes to servers 1 to " << state.active << std::endl;
+            }
+        }
+
         auto messages = balancer_in->getBag();
         for (const auto& msg : messages) {
-            int job_id = msg;
-
-            std::cout << state.current_time << "\tBalancer receives Job# " << job_id << " at balancer_in" << std::endl;
+            std::cout << state.current_time << "\tBalancer receives Job# " << msg << " at balancer_in" << std::endl;
             if (log_file.is_open()) {
-                log_file << state.current_time << "\tBalancer receives Job# "  << job_id <<" at balancer_in" << std::endl;
+                log_file << state.current_time << "\tBalancer receives Job# "  << msg <<" at balancer_in" << std::endl;
             }
 
-            bool was_empty = state.job_queue.empty();
-            state.job_queue.push(job_id);
-            
-            if (was_empty) {
-                state.phase = true;  
-                state.sigma = dispatch_time;  
+            if (max_jobs > 0 && held(state) >= max_jobs) {
+                state.shed++;
+                std::cout << state.current_time << "\tBalancer sheds job# " << msg << ", " << max_jobs << " jobs held" << std::endl;
+                if (log_file.is_open()) {
+                    log_file << state.current_time << "\tBalancer sheds job# " << msg << ", " << max_jobs << " jobs held" << std::endl;
+                }
+                continue;
             }
+            state.job_queue.push(msg);
+            assignWorkers(state);
+            state.max_queue = std::max(state.max_queue, static_cast<int>(state.job_queue.size()));
+        }
+        if (hedging.enabled) {
+            scheduleHedge(state);
         }
     }
     
@@ -110,43 +664,212 @@ class balancer : public Atomic<balancerState> {
     void output(const balancerState& state) const override {
 
 
-        state.current_time += state.sigma;
+        double dt = nextEvent(state);
+        state.current_time += dt;
         
-        if (!state.job_queue.empty()) {
+        if (state.sigma <= dt && !state.dispatching.empty()) {
 
-            int job_id = state.job_queue.front();
+            const job& next = state.dispatching[nextSlot(state)].item;
+            int target = selectServer(state, next);
             
-            if (job_id % 3 == 0) {
+            if (target < 0) {
+
+                std::cout << state.current_time << "\tBalancer rejects job# " << next << ", no server in rotation" << std::endl;
+                if (log_file.is_open()) {
+                    log_file << state.current_time << "\tBalancer rejects job# " << next << ", no server in rotation" << std::endl;
+                }
+
+            } else if (target == 0) {
 
-                std::cout << state.current_time << "\tBalancer sends job# " << job_id << " to server 1 at balancer_out1" << std::endl;
+                std::cout << state.current_time << "\tBalancer sends job# " << next << " to server 1 at balancer_out1" << std::endl;
                 if (log_file.is_open()) {
-                    log_file << state.current_time << "\tBalancer sends job# " << job_id << " to server 1 at balancer_out1" << std::endl;
+                    log_file << state.current_time << "\tBalancer sends job# " << next << " to server 1 at balancer_out1" << std::endl;
                 }
-                balancer_out1->addMessage(job_id);
+                balancer_out1->addMessage(next);
 
-            } else if (job_id % 3 == 1) {
+            } else if (target == 1) {
 
-                std::cout << state.current_time << "\tBalancer sends job# " << job_id << " to server 2 at balancer_out2" << std::endl;
+                std::cout << state.current_time << "\tBalancer sends job# " << next << " to server 2 at balancer_out2" << std::endl;
                 if (log_file.is_open()) {
-                    log_file << state.current_time << "\tBalancer sends job# " << job_id << " to server 2 at balancer_out2" << std::endl;
+                    log_file << state.current_time << "\tBalancer sends job# " << next << " to server 2 at balancer_out2" << std::endl;
                 }
-                balancer_out2->addMessage(job_id);
+                balancer_out2->addMessage(next);
 
             } else {  
 
-                std::cout << state.current_time << "\tBalancer sends job# " << job_id << " to server 3 at balancer_out3" << std::endl;
+                std::cout << state.current_time << "\tBalancer sends job# " << next << " to server 3 at balancer_out3" << std::endl;
                 if (log_file.is_open()) {
-                    log_file << state.current_time << "\tBalancer sends job# " << job_id << " to server 3 at balancer_out3" << std::endl;
+                    log_file << state.current_time << "\tBalancer sends job# " << next << " to server 3 at balancer_out3" << std::endl;
                 }
-                balancer_out3->addMessage(job_id);
+                balancer_out3->addMessage(next);
 
             }
         }
+
+        if (state.hedge_sigma <= dt) {
+            int target = hedgeTarget(state);
+            if (target >= 0) {
+                const job& copy = state.in_flight.at(state.hedge_candidates.front()).item;
+                std::cout << state.current_time << "\tBalancer hedges job# " << copy << " to server " << target + 1 << " at balancer_out" << target + 1 << std::endl;
+                if (log_file.is_open()) {
+                    log_file << state.current_time << "\tBalancer hedges job# " << copy << " to server " << target + 1 << " at balancer_out" << target + 1 << std::endl;
+                }
+                std::array<Port<job>, balancerConfig::MAX_SERVERS> out = {balancer_out1, balancer_out2, balancer_out3};
+                out[target]->addMessage(copy);
+            }
+        }
+
+        for (const auto& finished : state.cancelling) {
+            std::cout << state.current_time << "\tBalancer cancels the other copy of job# " << finished << " at balancer_out_cancel" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tBalancer cancels the other copy of job# " << finished << " at balancer_out_cancel" << std::endl;
+            }
+            balancer_out_cancel->addMessage(finished);
+        }
     }
     
+    // checkpoint: writes the state as seen at simulation time t
+    void save(std::ostream& os, const balancerState& state, double t) const {
+        snapshot::write(os, state.phase);
+        snapshot::write(os, state.job_queue);
+        snapshot::write(os, snapshot::remaining(state.sigma, state.current_time, t));
+        snapshot::write(os, static_cast<std::uint64_t>(state.dispatching.size()));
+        for (const auto& slot : state.dispatching) {
+            dispatchSlot{slot.item, snapshot::remaining(slot.sigma, state.current_time, t)}.save(os);
+        }
+        snapshot::write(os, state.current_weight);
+        snapshot::write(os, state.outstanding);
+        snapshot::write(os, state.dispatched);
+        snapshot::write(os, snapshot::remaining(state.probe_sigma, state.current_time, t));
+        snapshot::write(os, state.reported);
+        snapshot::write(os, state.healthy);
+        snapshot::write(os, state.redirected);
+        snapshot::write(os, state.rejected);
+        snapshot::write(os, state.active);
+        snapshot::write(os, static_cast<std::uint64_t>(state.in_flight.size()));
+        for (const auto& [id, entry] : state.in_flight) {
+            entry.save(os);
+        }
+        snapshot::write(os, std::vector<int>(state.hedge_candidates.begin(), state.hedge_candidates.end()));
+        snapshot::write(os, snapshot::remaining(state.hedge_sigma, state.current_time, t));
+        snapshot::write(os, static_cast<std::uint64_t>(state.cancelling.size()));
+        for (const auto& finished : state.cancelling) {
+            finished.save(os);
+        }
+        snapshot::write(os, state.hedges);
+        snapshot::write(os, state.hedge_wins);
+        snapshot::write(os, state.response);
+        snapshot::write(os, state.max_queue);
+        snapshot::write(os, state.shed);
+        snapshot::writeEngine(os, rng);
+        snapshot::writeEngine(os, dist);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, balancerState& state, double t) const {
+        state.current_time = t;
+        return snapshot::read(is, state.phase) && snapshot::read(is, state.job_queue) && snapshot::read(is, state.sigma) && readWorkers(is, state)
+            && snapshot::read(is, state.current_weight) && snapshot::read(is, state.outstanding) && snapshot::read(is, state.dispatched)
+            && snapshot::read(is, state.probe_sigma) && snapshot::read(is, state.reported) && snapshot::read(is, state.healthy)
+            && snapshot::read(is, state.redirected) && snapshot::read(is, state.rejected) && snapshot::read(is, state.active)
+            && readHedging(is, state) && snapshot::read(is, state.max_queue) && snapshot::read(is, state.shed) && snapshot::readEngine(is, rng) && snapshot::readEngine(is, dist);
+    }
+
+    static bool readWorkers(std::istream& is, balancerState& state) {
+        std::uint64_t size = 0;
+        if (!snapshot::read(is, size)) {
+            return false;
+        }
+        state.dispatching.assign(size, dispatchSlot{});
+        for (auto& slot : state.dispatching) {
+            if (!slot.restore(is)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool readHedging(std::istream& is, balancerState& state) {
+        std::uint64_t size = 0;
+        if (!snapshot::read(is, size)) {
+            return false;
+        }
+        state.in_flight.clear();
+        for (std::uint64_t i = 0; i < size; i++) {
+            inFlightJob entry{};
+            if (!entry.restore(is)) {
+                return false;
+            }
+            state.in_flight[entry.item.id] = entry;
+        }
+        std::vector<int> candidates;
+        if (!snapshot::read(is, candidates) || !snapshot::read(is, state.hedge_sigma) || !snapshot::read(is, size)) {
+            return false;
+        }
+        state.hedge_candidates.assign(candidates.begin(), candidates.end());
+        state.cancelling.assign(size, job{});
+        for (auto& finished : state.cancelling) {
+            if (!finished.restore(is)) {
+                return false;
+            }
+        }
+        return snapshot::read(is, state.hedges) && snapshot::read(is, state.hedge_wins) && snapshot::read(is, state.response);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
+    // summary of the jobs sent to each server
+    void report(std::ostream& os, const balancerState& state) const {
+        os << "balancer (" << policyName(policy) << "):";
+        for (int i = 0; i < servers; i++) {
+            os << " server " << i + 1 << " <- " << state.dispatched[i];
+        }
+        os << ", redirected " << state.redirected << ", rejected " << state.rejected << ", queued " << state.job_queue.size() + state.dispatching.size();
+        if (max_jobs > 0) {
+            os << ", shed " << state.shed << " (limit " << max_jobs << " jobs)";
+        }
+        os << std::endl;
+        if (workers > 1 || dispatch_type != distributionType::constant) {
+            os << "dispatch (workers " << workers << ", " << distributionName(dispatch_type) << " " << dispatch_time << " s per job): busy workers "
+               << state.dispatching.size() << ", waiting " << state.job_queue.size() << ", max waiting " << state.max_queue << std::endl;
+        }
+        if (hedging.enabled) {
+            int jobs = 0;
+            for (int i = 0; i < servers; i++) {
+                jobs += state.dispatched[i];
+            }
+            os << "hedging (delay " << hedgeDelay(state) << "): hedged " << state.hedges << " of " << jobs << " jobs (+"
+               << (jobs > 0 ? 100.0 * state.hedges / jobs : 0.0) << "% dispatches), won by the duplicate " << state.hedge_wins << std::endl;
+            os << "response latency: ";
+            state.response.print(os);
+            os << std::endl;
+        }
+    }
+
+    // adds the queue and the dropped jobs of this balancer to a metrics sample
+    void sample(metricsSample& m, const balancerState& state) const {
+        m.balancer_queue += static_cast<int>(state.job_queue.size() + state.dispatching.size());
+        m.shed += state.shed;
+        m.rejected += state.rejected;
+    }
+
+    void sample(metricsSample& m) const {
+        sample(m, state);
+    }
+
+    void report(std::ostream& os) const {
+        report(os, state);
+    }
+
     // time_advance function
     [[nodiscard]] double timeAdvance(const balancerState& state) const override {
-        return state.sigma;  
+        return nextEvent(state);
     }
     
     // destructor to close log file
@@ -0,0 +1,290 @@
+#ifndef DBCACHE_HPP
+#define DBCACHE_HPP
+
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <deque>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/job.hpp"
+#include "../utils/lrucache.hpp"
+#include "../utils/lfucache.hpp"
+
+using namespace cadmium;
+
+// Key evicted when the cache tier is full
+enum class evictionPolicy {
+    lru,  // least recently used
+    lfu   // least frequently used, least recently used among ties
+};
+
+inline const char* evictionName(evictionPolicy policy) {
+    return policy == evictionPolicy::lfu ? "lfu" : "lru";
+}
+
+inline bool parseEviction(const std::string& name, evictionPolicy& policy) {
+    if (name == "lru") {
+        policy = evictionPolicy::lru;
+    } else if (name == "lfu") {
+        policy = evictionPolicy::lfu;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct dbCacheConfig {
+    static constexpr int MAX_SERVERS = 3;  // acknowledgment ports
+
+    bool enabled = false;
+    int capacity = 1000;                             // keys the cache holds
+    evictionPolicy eviction = evictionPolicy::lru;
+    int keys = 10000;                                // keys the DB queries are drawn from
+    double zipf = 1.0;                               // skew of the key popularity (Zipf exponent), 0 for uniform
+    double hit_time = 0.01;                          // time to answer a hit
+};
+
+// A hit answered hit_time after its lookup
+struct cacheHit {
+    job item;
+    double due;
+
+    void save(std::ostream& os) const {
+        item.save(os);
+        snapshot::write(os, due);
+    }
+
+    bool restore(std::istream& is) {
+        return item.restore(is) && snapshot::read(is, due);
+    }
+};
+
+struct dbcacheState {
+
+    lruCache lru;                // keys cached, with the lru eviction
+    lfuCache lfu;                // keys cached, with the lfu eviction
+    std::deque<cacheHit> hits;   // hits not answered yet, in lookup order
+    std::vector<job> misses;     // forwarded to the DB at the next output
+    int lookups;
+    int hit_count;
+    mutable double current_time;
+
+    explicit dbcacheState() : lookups(0), hit_count(0), current_time(0.0) { }
+};
+
+#ifndef NO_LOGGING
+std::ostream& operator<<(std::ostream &out, const dbcacheState& state) {
+    out << "{pending_hits: " << state.hits.size() << ", lookups: " << state.lookups << ", hits: " << state.hit_count << "}";
+    return out;
+}
+#endif
+
+// Cache tier between the servers and the DB server. Each query a server sends reads
+// a key drawn from a Zipf popularity over `keys` keys. A hit is acknowledged to the
+// server hit_time later on dbcache_out<server>; a miss goes on to the DB, whose
+// acknowledgment reaches the server directly, and its key is cached (evicting by
+// LRU or LFU when the cache is full). Only the misses consume DB capacity.
+class dbcache : public Atomic<dbcacheState> {
+    public:
+
+    // queries of the servers (server_out2)
+    Port<job> dbcache_in;
+
+    // misses, to the DB server
+    Port<job> dbcache_out_db;
+
+    // acknowledgments of the hits, to each server
+    Port<job> dbcache_out1;
+    Port<job> dbcache_out2;
+    Port<job> dbcache_out3;
+
+    dbCacheConfig config;
+
+    mutable std::ofstream log_file;
+    mutable std::mt19937 rng;                               // random number generator
+    mutable std::uniform_real_distribution<double> unit;    // position in the popularity distribution
+    std::vector<double> popularity;                         // cumulative popularity of keys 0 to keys - 1
+
+    explicit dbcache(const std::string& id, const dbCacheConfig& cfg, const std::string& log_path = "simulation_results/dbcache_log.txt", unsigned int seed = std::random_device{}())
+        : Atomic<dbcacheState>(id, dbcacheState()), config(cfg), rng(seed), unit(0.0, 1.0)
+    {
+        double total = 0.0;
+        for (int k = 1; k <= config.keys; k++) {
+            total += 1.0 / std::pow(static_cast<double>(k), config.zipf);
+            popularity.push_back(total);
+        }
+        state.lru = lruCache(config.capacity);
+        state.lfu = lfuCache(config.capacity);
+
+        dbcache_in = addInPort<job>("dbcache_in");
+
+        dbcache_out_db = addOutPort<job>("dbcache_out_db");
+        dbcache_out1 = addOutPort<job>("dbcache_out1");
+        dbcache_out2 = addOutPort<job>("dbcache_out2");
+        dbcache_out3 = addOutPort<job>("dbcache_out3");
+
+        log_file.open(log_path, std::ios::app);
+        if (!log_file.is_open()) {
+            std::cerr << "Warning: Could not open log file: " << log_path << std::endl;
+        }
+    }
+
+    // key read by a query, drawn from the popularity distribution
+    int drawKey() const {
+        double u = unit(rng) * popularity.back();
+        auto it = std::lower_bound(popularity.begin(), popularity.end(), u);
+        return static_cast<int>(std::min<std::ptrdiff_t>(it - popularity.begin(), config.keys - 1));
+    }
+
+    // internal transition
+    void internalTransition(dbcacheState& state) const override {
+        state.misses.clear();
+        while (!state.hits.empty() && due(state.hits.front(), state)) {
+            state.hits.pop_front();
+        }
+    }
+
+    // external transition
+    void externalTransition(dbcacheState& state, double e) const override {
+
+        state.current_time += e;
+
+        for (const auto& msg : dbcache_in->getBag()) {
+            int key = drawKey();
+            bool hit = (config.eviction == evictionPolicy::lfu) ? state.lfu.access(key) : state.lru.access(key);
+            state.lookups++;
+            if (hit) {
+                state.hit_count++;
+                state.hits.push_back({msg, state.current_time + config.hit_time});
+            } else {
+                state.misses.push_back(msg);
+            }
+        }
+    }
+
+    // output function
+    void output(const dbcacheState& state) const override {
+
+        state.current_time += timeAdvance(state);
+
+        for (const auto& miss : state.misses) {
+            std::cout << state.current_time << "\tCache miss for job# " << miss << " from server#" << miss.server << ", sent to the DB at dbcache_out_db" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tCache miss for job# " << miss << " from server#" << miss.server << ", sent to the DB at dbcache_out_db" << std::endl;
+            }
+            dbcache_out_db->addMessage(miss);
+        }
+
+        std::array<Port<job>, dbCacheConfig::MAX_SERVERS> out = {dbcache_out1, dbcache_out2, dbcache_out3};
+        for (std::size_t k = 0; k < state.hits.size() && due(state.hits[k], state); k++) {
+            int server_id = state.hits[k].item.server;
+            if (server_id < 1 || server_id > dbCacheConfig::MAX_SERVERS) {
+                continue;
+            }
+            std::cout << state.current_time << "\tCache hit for job# " << state.hits[k].item << ", sent back to server#" << server_id << " at dbcache_out" << server_id << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tCache hit for job# " << state.hits[k].item << ", sent back to server#" << server_id << " at dbcache_out" << server_id << std::endl;
+            }
+            out[server_id - 1]->addMessage(state.hits[k].item);
+        }
+    }
+
+    // checkpoint: writes the state and the RNG as seen at simulation time t
+    void save(std::ostream& os, const dbcacheState& state, [[maybe_unused]] double t) const {
+        state.lru.save(os);
+        state.lfu.save(os);
+        snapshot::write(os, static_cast<std::uint64_t>(state.hits.size()));
+        for (const auto& hit : state.hits) {
+            hit.save(os);
+        }
+        snapshot::write(os, static_cast<std::uint64_t>(state.misses.size()));
+        for (const auto& miss : state.misses) {
+            miss.save(os);
+        }
+        snapshot::write(os, state.lookups);
+        snapshot::write(os, state.hit_count);
+        snapshot::writeEngine(os, rng);
+        snapshot::writeEngine(os, unit);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, dbcacheState& state, double t) const {
+        state.current_time = t;
+        std::uint64_t size = 0;
+        if (!state.lru.restore(is) || !state.lfu.restore(is) || !snapshot::read(is, size)) {
+            return false;
+        }
+        state.hits.assign(size, cacheHit{});
+        for (auto& hit : state.hits) {
+            if (!hit.restore(is)) {
+                return false;
+            }
+        }
+        if (!snapshot::read(is, size)) {
+            return false;
+        }
+        state.misses.assign(size, job{});
+        for (auto& miss : state.misses) {
+            if (!miss.restore(is)) {
+                return false;
+            }
+        }
+        return snapshot::read(is, state.lookups) && snapshot::read(is, state.hit_count)
+            && snapshot::readEngine(is, rng) && snapshot::readEngine(is, unit);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
+    // summary of the lookups and of the load left for the DB over [0, t]
+    void report(std::ostream& os, const dbcacheState& state, double t) const {
+        int misses = state.lookups - state.hit_count;
+        os << "db cache (" << evictionName(config.eviction) << ", " << config.capacity << " of " << config.keys << " keys, zipf " << config.zipf
+           << "): lookups " << state.lookups << ", hits " << (state.lookups > 0 ? 100.0 * state.hit_count / state.lookups : 0.0)
+           << "%, misses to the DB " << (t > 0 ? misses / t : 0.0) << "/s" << std::endl;
+    }
+
+    void report(std::ostream& os, double t) const {
+        report(os, state, t);
+    }
+
+    // time_advance function: misses go at once, hits when their answer is due
+    [[nodiscard]] double timeAdvance(const dbcacheState& state) const override {
+        if (!state.misses.empty()) {
+            return 0.0;
+        }
+        if (state.hits.empty()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return std::max(0.0, state.hits.front().due - state.current_time);
+    }
+
+    // destructor to close log file
+    ~dbcache() {
+        if (log_file.is_open()) {
+            log_file.close();
+        }
+    }
+
+    private:
+
+    // answer times are absolute, current_time is accumulated from the time advances
+    static bool due(const cacheHit& hit, const dbcacheState& state) {
+        return hit.due <= state.current_time + 1e-9;
+    }
+};
+
+#endif
@@ -3,28 +3,76 @@
 
 #include <iostream>
 #include <fstream>
-#include <queue>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
 #include <limits>
+#include <algorithm>
 #include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/stats.hpp"
+#include "../utils/metrics.hpp"
+#include "../utils/job.hpp"
+#include "../utils/classqueue.hpp"
 
 using namespace cadmium;
 
+// Batching of the DB queries: the queued jobs are coalesced into one round trip
+// costing a fixed overhead plus a per-job time
+struct batchConfig {
+    int max_size = 1;       // jobs per round trip, 1 to serve them one by one in the processing time
+    double max_wait = 0;    // time the oldest queued job may wait for a batch to fill
+    double overhead = 1;    // time of a round trip, whatever its size
+    double per_item = 0;    // added to the round trip for each job of the batch
+
+    [[nodiscard]] bool enabled() const {
+        return max_size > 1;
+    }
+};
+
+// A job queued at the DB and the time it arrived
+struct dbRequest {
+    job item;
+    double arrival;
+
+    void save(std::ostream& os) const {
+        item.save(os);
+        snapshot::write(os, arrival);
+    }
+
+    bool restore(std::istream& is) {
+        return item.restore(is) && snapshot::read(is, arrival);
+    }
+};
+
 // DBServer state structure
 struct dbserverState {
     bool phase;  // true = active, false = passive
     double sigma;
-    std::queue<int> job_queue;  
+    classQueue<dbRequest> job_queue;  // jobs waiting for the DB
+    job current;                      // job being processed
     mutable double current_time;
     mutable int jobs_done;
 
-    explicit dbserverState() : phase(false), sigma(std::numeric_limits<double>::infinity()), current_time(0.0), jobs_done(0) {}
+    std::vector<dbRequest> batch;  // jobs of the round trip in progress (batching)
+    int batches;                   // round trips started
+    double busy_time;              // total time of the round trips
+    latencyStats latency;          // time from the arrival at the DB to the acknowledgment (batching)
+
+    explicit dbserverState() : phase(false), sigma(std::numeric_limits<double>::infinity()), current{}, current_time(0.0), jobs_done(0), batches(0), busy_time(0.0) {}
+
+    // jobs at the DB, queued or in progress
+    [[nodiscard]] std::size_t held() const {
+        return job_queue.size() + (phase ? std::max<std::size_t>(batch.size(), 1) : 0);
+    }
 };
 
 
 #ifndef NO_LOGGING
 std::ostream& operator<<(std::ostream& os, const dbserverState& state) {
     os << "{phase: " << (state.phase ? "active" : "passive") 
-       << ", queue_size: " << state.job_queue.size() << ", jobs_done: " << state.jobs_done << "}";
+       << ", queue_size: " << state.held() << ", jobs_done: " << state.jobs_done << "}";
     return os;
 }
 #endif
@@ -32,25 +80,28 @@ std::ostream& operator<<(std::ostream& os, const dbserverState& state) {
 class dbserver : public Atomic<dbserverState> {
 public:
 
-    Port<int> dbserver_in;      
-    Port<int> dbserver_out1;   
-    Port<int> dbserver_out2;    
-    Port<int> dbserver_out3;    
+    Port<job> dbserver_in;      
+    Port<job> dbserver_out1;    // acknowledgments of the queries of each server
+    Port<job> dbserver_out2;    
+    Port<job> dbserver_out3;    
 
 private:
     double dbprocessing_time;
+    queueConfig queueing;  // order in which the queued classes are served
+    batchConfig batching;  // coalescing of the queued jobs into round trips
     mutable std::ofstream log_file;  
 
 public:
 
-    explicit dbserver(const std::string& id, double proc_time, const std::string& log_path = "simulation_results/dbserver_log.txt"): Atomic<dbserverState>(id, dbserverState()), dbprocessing_time(proc_time) {
+    explicit dbserver(const std::string& id, double proc_time, const std::string& log_path = "simulation_results/dbserver_log.txt", const queueConfig& queue_config = queueConfig(),
+                      const batchConfig& batch_config = batchConfig()): Atomic<dbserverState>(id, dbserverState()), dbprocessing_time(proc_time), queueing(queue_config), batching(batch_config) {
         
-        dbserver_in = addInPort<int>("dbserver_in");
+        dbserver_in = addInPort<job>("dbserver_in");
         
        
-        dbserver_out1 = addOutPort<int>("dbserver_out1");
-        dbserver_out2 = addOutPort<int>("dbserver_out2");
-        dbserver_out3 = addOutPort<int>("dbserver_out3");
+        dbserver_out1 = addOutPort<job>("dbserver_out1");
+        dbserver_out2 = addOutPort<job>("dbserver_out2");
+        dbserver_out3 = addOutPort<job>("dbserver_out3");
         
       
         log_file.open(log_path, std::ios::app);
@@ -59,15 +110,53 @@ public:
         }
     }
 
+    // starts a round trip when a full batch is queued or the oldest queued job waited max_wait, otherwise waits for that
+    void startBatch(dbserverState& state) const {
+        state.phase = false;
+        state.sigma = std::numeric_limits<double>::infinity();
+        if (state.job_queue.empty()) {
+            return;
+        }
+        double oldest = std::numeric_limits<double>::infinity();
+        for (int c = 0; c < job::MAX_CLASSES; c++) {
+            if (state.job_queue.size(c) > 0) {
+                oldest = std::min(oldest, state.job_queue.front(c).arrival);
+            }
+        }
+        double wait = oldest + batching.max_wait - state.current_time;
+        if (state.job_queue.size() < static_cast<std::size_t>(batching.max_size) && wait > 1e-9) {
+            state.sigma = wait;
+            return;
+        }
+        while (state.batch.size() < static_cast<std::size_t>(batching.max_size) && !state.job_queue.empty()) {
+            state.batch.push_back(state.job_queue.pop(queueing));
+        }
+        state.phase = true;
+        state.sigma = batching.overhead + batching.per_item * static_cast<double>(state.batch.size());
+        state.busy_time += state.sigma;
+        state.batches++;
+        std::cout << state.current_time << "\tDBServer starts a batch of " << state.batch.size() << " jobs" << std::endl;
+        if (log_file.is_open()) {
+            log_file << state.current_time << "\tDBServer starts a batch of " << state.batch.size() << " jobs" << std::endl;
+        }
+    }
+
     // internal transition
     void internalTransition(dbserverState& state) const override {
 
-        if (!state.job_queue.empty()) {
-            state.job_queue.pop();
+        if (batching.enabled()) {
+            if (state.phase) {
+                for (const auto& request : state.batch) {
+                    state.latency.add(state.current_time - request.arrival);
+                }
+                state.batch.clear();
+            }
+            startBatch(state);
+            return;
         }
 
-   
         if (!state.job_queue.empty()) {
+            state.current = state.job_queue.pop(queueing).item;
             state.phase = true;  
             state.sigma = dbprocessing_time;
         } else {
@@ -85,24 +174,27 @@ public:
             state.sigma -= e;  
         }
 
-        auto messages = dbserver_in->getBag();
-
-        if (!messages.empty()) {
-
-            int server_id = messages.back();
-
-            state.job_queue.push(server_id);
+        for (const auto& msg : dbserver_in->getBag()) {
 
-            std::cout << state.current_time << "\tDBServer receives job from server#" << server_id << " at dbserver_in1" << std::endl;
+            std::cout << state.current_time << "\tDBServer receives job from server#" << msg.server << classSuffix(msg) << " at dbserver_in1" << std::endl;
             if (log_file.is_open()) {
-                log_file << state.current_time << "\tDBServer receives job from server#" << server_id << " at dbserver_in1" << std::endl;
+                log_file << state.current_time << "\tDBServer receives job from server#" << msg.server << classSuffix(msg) << " at dbserver_in1" << std::endl;
             }
 
-            if (state.job_queue.size() == 1) {
+            if (batching.enabled()) {
+                state.job_queue.push(msg.job_class, dbRequest{msg, state.current_time});
+            } else if (!state.phase) {
+                state.current = msg;
                 state.phase = true;  
                 state.sigma = dbprocessing_time;
+            } else {
+                state.job_queue.push(msg.job_class, dbRequest{msg, state.current_time});
             }
         }
+
+        if (batching.enabled() && !state.phase) {
+            startBatch(state);
+        }
     }
 
     // output function
@@ -110,38 +202,16 @@ public:
      
         state.current_time += state.sigma;
         
-        if (!state.job_queue.empty()) {
-
-            int server_id = state.job_queue.front();
-
-            state.jobs_done++;
-            
-            if (server_id == 1) {
-                dbserver_out1->addMessage(server_id);
-                std::cout << state.current_time << "\tDBServer sends job back to server#" << server_id << " at dbserver_out1" << std::endl;
-                std::cout << state.current_time << "\tJobs done by DB Server: " << state.jobs_done << std::endl;
-                if (log_file.is_open()) {
-                    log_file << state.current_time << "\tDBServer sends job back to server#" << server_id << " at dbserver_out1" << std::endl;
-                    log_file << state.current_time << "\tJobs done by DB Server: " << state.jobs_done << std::endl;
-                }
-            } else if (server_id == 2) {
-                dbserver_out2->addMessage(server_id);
-                std::cout << state.current_time << "\tDBServer sends job back to server#" << server_id << " at dbserver_out2" << std::endl;
-                std::cout << state.current_time << "\tJobs done by DB Server: " << state.jobs_done << std::endl;
-                if (log_file.is_open()) {
-                    log_file << state.current_time << "\tDBServer sends job back to server#" << server_id << " at dbserver_out2" << std::endl;
-                    log_file << state.current_time << "\tJobs done by DB Server: " << state.jobs_done << std::endl;
-                }
-            } else if (server_id == 3) {
-                dbserver_out3->addMessage(server_id);
-                std::cout << state.current_time << "\tDBServer sends job back to server#" << server_id << " at dbserver_out3" << std::endl;
-                std::cout << state.current_time << "\tJobs done by DB Server: " << state.jobs_done << std::endl;
-                if (log_file.is_open()) {
-                    log_file << state.current_time << "\tDBServer sends job back to server#" << server_id << " at dbserver_out3" << std::endl;
-                    log_file << state.current_time << "\tJobs done by DB Server: " << state.jobs_done << std::endl;
-                }
+        if (!state.phase) {
+            return;  // a batch stopped waiting: it starts in the internal transition
+        }
+        if (batching.enabled()) {
+            // one round trip acknowledges every job of the batch
+            for (const auto& request : state.batch) {
+                acknowledge(state, request.item);
             }
-             
+        } else {
+            acknowledge(state, state.current);
         }
     }
 
@@ -151,9 +221,83 @@ public:
     //     externalTransition(state, 0.0);   
     // }
 
+    // checkpoint: writes the state as seen at simulation time t
+    void save(std::ostream& os, const dbserverState& state, double t) const {
+        snapshot::write(os, state.phase);
+        state.job_queue.save(os);
+        state.current.save(os);
+        snapshot::write(os, snapshot::remaining(state.sigma, state.current_time, t));
+        snapshot::write(os, state.jobs_done);
+        snapshot::write(os, static_cast<std::uint64_t>(state.batch.size()));
+        for (const auto& request : state.batch) {
+            request.save(os);
+        }
+        snapshot::write(os, state.batches);
+        snapshot::write(os, state.busy_time);
+        snapshot::write(os, state.latency);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, dbserverState& state, double t) const {
+        state.current_time = t;
+        return snapshot::read(is, state.phase) && state.job_queue.restore(is) && state.current.restore(is)
+            && snapshot::read(is, state.sigma) && snapshot::read(is, state.jobs_done)
+            && readBatch(is, state.batch) && snapshot::read(is, state.batches) && snapshot::read(is, state.busy_time)
+            && snapshot::read(is, state.latency);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
+    static bool readBatch(std::istream& is, std::vector<dbRequest>& batch) {
+        std::uint64_t size = 0;
+        if (!snapshot::read(is, size)) {
+            return false;
+        }
+        batch.assign(size, dbRequest{});
+        for (auto& request : batch) {
+            if (!request.restore(is)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // summary of the jobs finished and, with batching, of the round trips over [0, t]
+    void report(std::ostream& os, const dbserverState& state, double t) const {
+        os << "db server: jobs done " << state.jobs_done << ", queued " << state.held();
+        if (batching.enabled()) {
+            os << ", batches " << state.batches << " (mean size " << (state.batches > 0 ? static_cast<double>(state.jobs_done) / state.batches : 0.0)
+               << "), throughput " << (t > 0 ? state.jobs_done / t : 0.0) << "/s, utilisation " << (t > 0 ? 100.0 * state.busy_time / t : 0.0) << "%" << std::endl;
+            os << "db latency: ";
+            state.latency.print(os);
+        }
+        os << std::endl;
+    }
+
+    void report(std::ostream& os, double t) const {
+        report(os, state, t);
+    }
+
+    // adds the queue, the acknowledged queries and the busy time of this db server to a metrics sample
+    void sample(metricsSample& m, const dbserverState& state) const {
+        m.db_queue += static_cast<int>(state.held());
+        m.db_done += state.jobs_done;
+        m.db_busy += batching.enabled() ? state.busy_time : state.jobs_done * dbprocessing_time;
+    }
+
+    void sample(metricsSample& m) const {
+        sample(m, state);
+    }
+
     // time_advance function
     [[nodiscard]] double timeAdvance(const dbserverState& state) const override {
-        if (!state.phase) {
+        if (!state.phase && !batching.enabled()) {
             return std::numeric_limits<double>::infinity();  
         }
         return state.sigma;
@@ -165,6 +309,33 @@ public:
             log_file.close();
         }
     }
+
+private:
+
+    // sends the acknowledgment of a job back to its server; it carries the job, so a
+    // server receiving several in one bag tells its own query from stale ones
+    void acknowledge(const dbserverState& state, const job& item) const {
+
+        state.jobs_done++;
+
+        int server_id = item.server;
+        std::array<Port<job>, 3> out = {dbserver_out1, dbserver_out2, dbserver_out3};
+        if (server_id < 1 || server_id > static_cast<int>(out.size())) {
+            return;
+        }
+        out[server_id - 1]->addMessage(item);
+        std::cout << state.current_time << "\tDBServer sends job back to server#" << server_id << " at dbserver_out" << server_id << std::endl;
+        std::cout << state.current_time << "\tJobs done by DB Server: " << state.jobs_done << std::endl;
+        if (log_file.is_open()) {
+            log_file << state.current_time << "\tDBServer sends job back to server#" << server_id << " at dbserver_out" << server_id << std::endl;
+            log_file << state.current_time << "\tJobs done by DB Server: " << state.jobs_done << std::endl;
+        }
+    }
+
+    // class of the job in the log lines, omitted for class 0
+    static std::string classSuffix(const job& j) {
+        return j.job_class == 0 ? "" : " (class " + std::to_string(j.job_class) + ")";
+    }
 };
 
 #endif
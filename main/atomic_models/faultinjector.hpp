@@ -0,0 +1,200 @@
+#ifndef FAULTINJECTOR_HPP
+#define FAULTINJECTOR_HPP
+
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <vector>
+#include <limits>
+#include <random>
+#include <algorithm>
+#include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/control.hpp"
+
+using namespace cadmium;
+
+// One scheduled change of the status of a server
+struct faultEvent {
+    double time;
+    int server;             // 1 to MAX_SERVERS
+    serverStatus status;    // down = crash, draining = drain, up = recover
+};
+
+struct faultConfig {
+    static constexpr int MAX_SERVERS = 3;  // output ports of the fault injector
+
+    std::vector<faultEvent> schedule;                 // sorted by time
+    double mtbf = 0;                                  // mean time between random outages of each server, 0 for none
+    double mttr = 60;                                 // mean duration of a random outage
+    serverStatus outage = serverStatus::down;         // random outages crash or drain the server
+
+    [[nodiscard]] bool enabled() const {
+        return !schedule.empty() || mtbf > 0;
+    }
+};
+
+struct faultinjectorState {
+
+    std::size_t next_event;  // index of the next scheduled event
+    std::array<double, faultConfig::MAX_SERVERS> next_change;  // time of the next random outage or repair of each server
+    std::array<bool, faultConfig::MAX_SERVERS> in_outage;      // server currently in a random outage
+    double sigma;
+    mutable double current_time;
+
+    explicit faultinjectorState() : next_event(0), next_change{}, in_outage{}, sigma(std::numeric_limits<double>::infinity()), current_time(0.0) { }
+};
+
+#ifndef NO_LOGGING
+std::ostream& operator<<(std::ostream &out, const faultinjectorState& state) {
+    out << "{next_event: " << state.next_event << ", in_outage: [" << state.in_outage[0] << ", " << state.in_outage[1] << ", " << state.in_outage[2] << "]}";
+    return out;
+}
+#endif
+
+// Sends crash, drain and recover commands to the servers, at the scheduled times
+// and at random (exponential time between outages and exponential outage length).
+// The same commands go to the balancer health ports: they stand for the status a
+// health probe of the server would read.
+class faultinjector : public Atomic<faultinjectorState> {
+    public:
+
+    Port<int> faultinjector_out1;
+    Port<int> faultinjector_out2;
+    Port<int> faultinjector_out3;
+
+    faultConfig config;
+    int servers;
+
+    mutable std::ofstream log_file;
+    mutable std::mt19937 rng;                                   // random number generator
+    mutable std::exponential_distribution<double> failure_dist; // time between outages
+    mutable std::exponential_distribution<double> repair_dist;  // outage length
+
+    explicit faultinjector(const std::string& id, const faultConfig& cfg, int n_servers = 3, const std::string& log_path = "simulation_results/faultinjector_log.txt", unsigned int seed = std::random_device{}())
+        : Atomic<faultinjectorState>(id, faultinjectorState()), config(cfg), servers(n_servers), rng(seed),
+          failure_dist(cfg.mtbf > 0 ? 1.0 / cfg.mtbf : 1.0), repair_dist(1.0 / cfg.mttr)
+    {
+        for (int i = 0; i < faultConfig::MAX_SERVERS; i++) {
+            state.next_change[i] = (config.mtbf > 0 && i < servers) ? failure_dist(rng) : std::numeric_limits<double>::infinity();
+        }
+        state.sigma = nextTime(state);
+
+        faultinjector_out1 = addOutPort<int>("faultinjector_out1");
+        faultinjector_out2 = addOutPort<int>("faultinjector_out2");
+        faultinjector_out3 = addOutPort<int>("faultinjector_out3");
+
+        log_file.open(log_path, std::ios::app);
+        if (!log_file.is_open()) {
+            std::cerr << "Warning: Could not open log file: " << log_path << std::endl;
+        }
+    }
+
+    // time of the next scheduled or random event
+    [[nodiscard]] double nextTime(const faultinjectorState& state) const {
+        double t = std::numeric_limits<double>::infinity();
+        if (state.next_event < config.schedule.size()) {
+            t = config.schedule[state.next_event].time;
+        }
+        for (int i = 0; i < servers; i++) {
+            t = std::min(t, state.next_change[i]);
+        }
+        return t;
+    }
+
+    // internal transition
+    void internalTransition(faultinjectorState& state) const override {
+
+        while (state.next_event < config.schedule.size() && due(config.schedule[state.next_event].time, state)) {
+            state.next_event++;
+        }
+        for (int i = 0; i < servers; i++) {
+            if (due(state.next_change[i], state)) {
+                state.in_outage[i] = !state.in_outage[i];
+                state.next_change[i] += state.in_outage[i] ? repair_dist(rng) : failure_dist(rng);
+            }
+        }
+        state.sigma = nextTime(state) - state.current_time;
+    }
+
+    // external transition
+    void externalTransition([[maybe_unused]] faultinjectorState& state, [[maybe_unused]] double e) const override {
+        // No external inputs for this model
+    }
+
+    // output function
+    void output(const faultinjectorState& state) const override {
+
+        state.current_time += state.sigma;
+
+        for (std::size_t k = state.next_event; k < config.schedule.size() && due(config.schedule[k].time, state); k++) {
+            send(state, config.schedule[k].server, config.schedule[k].status);
+        }
+        for (int i = 0; i < servers; i++) {
+            if (due(state.next_change[i], state)) {
+                send(state, i + 1, state.in_outage[i] ? serverStatus::up : config.outage);
+            }
+        }
+    }
+
+    // checkpoint: writes the state and the RNG as seen at simulation time t
+    void save(std::ostream& os, const faultinjectorState& state, double t) const {
+        snapshot::write(os, state.next_event);
+        snapshot::write(os, state.next_change);
+        snapshot::write(os, state.in_outage);
+        snapshot::write(os, snapshot::remaining(state.sigma, state.current_time, t));
+        snapshot::writeEngine(os, rng);
+        snapshot::writeEngine(os, failure_dist);
+        snapshot::writeEngine(os, repair_dist);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, faultinjectorState& state, double t) const {
+        state.current_time = t;
+        return snapshot::read(is, state.next_event) && snapshot::read(is, state.next_change)
+            && snapshot::read(is, state.in_outage) && snapshot::read(is, state.sigma)
+            && snapshot::readEngine(is, rng) && snapshot::readEngine(is, failure_dist) && snapshot::readEngine(is, repair_dist);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
+    // time_advance function
+    [[nodiscard]] double timeAdvance(const faultinjectorState& state) const override {
+        return state.sigma;
+    }
+
+    // destructor to close log file
+    ~faultinjector() {
+        if (log_file.is_open()) {
+            log_file.close();
+        }
+    }
+
+    private:
+
+    // event times are absolute, current_time is accumulated from the sigmas
+    static bool due(double time, const faultinjectorState& state) {
+        return time <= state.current_time + 1e-9;
+    }
+
+    void send(const faultinjectorState& state, int server_id, serverStatus status) const {
+        if (server_id < 1 || server_id > servers) {
+            return;
+        }
+        const char* action = status == serverStatus::down ? "crashes" : (status == serverStatus::draining ? "drains" : "recovers");
+        std::cout << state.current_time << "\tFault injector " << action << " server " << server_id << " at faultinjector_out" << server_id << std::endl;
+        if (log_file.is_open()) {
+            log_file << state.current_time << "\tFault injector " << action << " server " << server_id << " at faultinjector_out" << server_id << std::endl;
+        }
+        std::array<Port<int>, faultConfig::MAX_SERVERS> out = {faultinjector_out1, faultinjector_out2, faultinjector_out3};
+        out[server_id - 1]->addMessage(static_cast<int>(status));
+    }
+};
+
+#endif
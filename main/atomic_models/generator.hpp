@@ -3,16 +3,27 @@
 
 #include <iostream>
 #include <fstream>
+#include <random>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <vector>
 #include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/distribution.hpp"
+#include "../utils/job.hpp"
+#include "../utils/trace.hpp"
 
 using namespace cadmium;
 
 struct generatorState {
     mutable int job_id;
+    int job_class;  // class of the next job
+    int session;    // session of the next job
     double sigma;
     mutable double current_time;
     
-    explicit generatorState(double output_rate = 0.1) : job_id(1), sigma(output_rate), current_time(0.0) { }
+    explicit generatorState(double output_rate = 0.1) : job_id(1), job_class(0), session(0), sigma(output_rate), current_time(0.0) { }
 };
 
 #ifndef NO_LOGGING
@@ -25,16 +36,69 @@ std::ostream& operator<<(std::ostream &out, const generatorState& state) {
 class generator : public Atomic<generatorState> {
     public:
     
-    Port<int> generator_out1;
+    Port<job> generator_out1;
     
-    double output_rate;
+    double output_rate;  // mean time between two jobs
+    distributionType arrival_type;
+    std::array<double, job::MAX_CLASSES> class_mix;  // share of the jobs in each class
+    int sessions;                                    // jobs belong to sessions 1 to sessions, 0 for none
+    std::vector<traceRecord> trace;                  // recorded requests replayed in place of the sampled ones, empty for none
     
     mutable std::ofstream log_file;
+    mutable std::mt19937 rng;                           // random number generator
+    mutable std::exponential_distribution<double> dist; // exponential distribution
+    mutable std::discrete_distribution<int> class_dist; // class of each job
+    mutable std::uniform_int_distribution<int> session_dist; // session of each job
+
+    double getInterarrivalTime() const {
+        return arrival_type == distributionType::exponential ? dist(rng) : output_rate;
+    }
+
+    // class of the next job; the RNG is only used when the mix has several classes,
+    // so single-class runs draw the same inter-arrival times as before
+    int getJobClass() const {
+        int classes = 0;
+        int last = 0;
+        for (int c = 0; c < job::MAX_CLASSES; c++) {
+            if (class_mix[c] > 0) {
+                classes++;
+                last = c;
+            }
+        }
+        return classes > 1 ? class_dist(rng) : last;
+    }
+    
+    // session of the next job, drawn only when sessions are configured
+    int getSession() const {
+        return sessions > 0 ? session_dist(rng) : 0;
+    }
+    
+    // schedules the job job_id: the next sampled one, or the next request of the trace (none after the last)
+    void scheduleNext(generatorState& state) const {
+        if (trace.empty()) {
+            state.sigma = getInterarrivalTime();
+            state.job_class = getJobClass();
+            state.session = getSession();
+            return;
+        }
+        auto next = static_cast<std::size_t>(state.job_id - 1);
+        if (next >= trace.size()) {
+            state.sigma = std::numeric_limits<double>::infinity();
+            return;
+        }
+        state.sigma = next == 0 ? trace[next].time : trace[next].time - trace[next - 1].time;
+        state.job_class = trace[next].job_class;
+        state.session = trace[next].session;
+    }
     
-    explicit generator(const std::string& id, double rate = 0.1, const std::string& log_path = "simulation_results/generator_log.txt") : Atomic<generatorState>(id, generatorState(rate)), output_rate(rate)
+    explicit generator(const std::string& id, double rate = 0.1, const std::string& log_path = "simulation_results/generator_log.txt", distributionType type = distributionType::constant, unsigned int seed = std::random_device{}(),
+        const std::array<double, job::MAX_CLASSES>& mix = {1, 0, 0, 0}, int n_sessions = 0, const std::vector<traceRecord>& replay = {})
+        : Atomic<generatorState>(id, generatorState(rate)), output_rate(rate), arrival_type(type), class_mix(mix), sessions(n_sessions), trace(replay), rng(seed), dist(1.0 / rate),
+          class_dist(mix.begin(), mix.end()), session_dist(1, std::max(1, n_sessions))
     {
+        scheduleNext(state);
 
-        generator_out1 = addOutPort<int>("generator_out1");
+        generator_out1 = addOutPort<job>("generator_out1");
         
         log_file.open(log_path, std::ios::app);
 
@@ -46,10 +110,11 @@ class generator : public Atomic<generatorState> {
     // internal transition
     void internalTransition(generatorState& state) const override {
         state.job_id = state.job_id + 1;
+        scheduleNext(state);
     }
     
     // external transition
-    void externalTransition(generatorState& state, double e) const override {
+    void externalTransition([[maybe_unused]] generatorState& state, [[maybe_unused]] double e) const override {
         // No external inputs for this model
     }
     
@@ -57,14 +122,48 @@ class generator : public Atomic<generatorState> {
     void output(const generatorState& state) const override {
 
         state.current_time += state.sigma;
-        int job_id = state.job_id;
-        std::cout << state.current_time << "\tGenerator outputs Job# " << job_id << " at generator_out1" << std::endl;
+        job next(state.job_id, state.job_class, 0, state.session);
+        std::cout << state.current_time << "\tGenerator outputs Job# " << next << " at generator_out1" << std::endl;
         if (log_file.is_open()) {
-            log_file << state.current_time << "\tGenerator outputs Job# " << job_id << " at generator_out1" << std::endl;
+            log_file << state.current_time << "\tGenerator outputs Job# " << next << " at generator_out1" << std::endl;
         }
-        generator_out1->addMessage(job_id);
+        generator_out1->addMessage(next);
     }
     
+    // number of jobs sent so far
+    [[nodiscard]] int jobsGenerated(const generatorState& state) const {
+        return state.job_id - 1;
+    }
+
+    [[nodiscard]] int jobsGenerated() const {
+        return jobsGenerated(state);
+    }
+
+    // checkpoint: writes the state as seen at simulation time t
+    void save(std::ostream& os, const generatorState& state, double t) const {
+        snapshot::write(os, state.job_id);
+        snapshot::write(os, state.job_class);
+        snapshot::write(os, state.session);
+        snapshot::write(os, snapshot::remaining(state.sigma, state.current_time, t));
+        snapshot::writeEngine(os, rng);
+        snapshot::writeEngine(os, dist);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, generatorState& state, double t) const {
+        state.current_time = t;
+        return snapshot::read(is, state.job_id) && snapshot::read(is, state.job_class) && snapshot::read(is, state.session) && snapshot::read(is, state.sigma)
+            && snapshot::readEngine(is, rng) && snapshot::readEngine(is, dist);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
     //  time_advance function
     [[nodiscard]] double timeAdvance(const generatorState& state) const override {
         return state.sigma;  
@@ -4,31 +4,99 @@
 #include <iostream>
 #include <fstream>
 #include <queue>
+#include <vector>
+#include <cstdint>
 #include <limits>
 #include <random>
 #include <cmath>
+#include <algorithm>
 #include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/distribution.hpp"
+#include "../utils/stats.hpp"
+#include "../utils/metrics.hpp"
+#include "../utils/job.hpp"
+#include "../utils/control.hpp"
+#include "../utils/classqueue.hpp"
+#include "../utils/lrucache.hpp"
+#include "../utils/standin.hpp"
 
 using namespace cadmium;
 
+// A job in a server queue and the time it reached the pool; also the message
+// that moves a stolen job to the thief (item.server is then the thief)
+struct queuedJob {
+    job item;
+    double arrival;
+    bool stolen = false;  // taken from a peer: its processing pays the steal cost
+
+    void save(std::ostream& os) const {
+        item.save(os);
+        snapshot::write(os, arrival);
+        snapshot::write(os, stolen);
+    }
+
+    bool restore(std::istream& is) {
+        return item.restore(is) && snapshot::read(is, arrival) && snapshot::read(is, stolen);
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const queuedJob& queued) {
+    out << queued.item << " for server " << queued.item.server;
+    return out;
+}
+
 struct serverState {
     
     bool phase;  // true = active, false = passive
 
     bool waiting;   // true = waiting for DB response, false = processing
 
-    std::queue<int> job_queue;
-    int current_job_id;
+    classQueue<queuedJob> job_queue;  // jobs not started yet
+    queuedJob current;                // job processed or waiting for the DB
     double sigma;
     mutable double current_time;  
+
+    int jobs_done;     // jobs finished (DB acknowledgment received)
+    double busy_time;  // total processing time of the started jobs
+
+    serverStatus status;
+    int lost_jobs;     // jobs dropped by a crash or received while down
+    std::vector<int> stale_acks;  // ids of the jobs lost in a crash or cancelled while waiting for the DB: their acknowledgments are ignored
+
+    std::array<latencyStats, job::MAX_CLASSES> latency;  // time from arrival to DB acknowledgment, per class
+    timeline completions;                                // finished jobs per minute (or per longer window when bounded)
+
+    lruCache cache;    // sessions whose data the server holds
+    int cache_hits;    // started jobs whose session was cached
+    int cache_misses;
+
+    std::vector<queuedJob> handing_over;  // queued jobs given to idle peers, sent at the next output
+    int stolen_in;     // jobs taken from peers
+    int stolen_out;    // jobs given to peers
+    std::vector<int> refusing;  // thieves of the steals that found no queued job, answered at the next output
+
+    std::vector<job> cancelling;  // copies of hedged jobs dropped here, reported at the next output
+    int cancelled;     // copies dropped because the other copy finished first
     
-    explicit serverState() : phase(false), waiting(false), current_job_id(0), sigma(std::numeric_limits<double>::infinity()), current_time(0.0) { }
+    explicit serverState() : phase(false), waiting(false), current{}, sigma(std::numeric_limits<double>::infinity()), current_time(0.0), jobs_done(0), busy_time(0.0),
+        status(serverStatus::up), lost_jobs(0), cache_hits(0), cache_misses(0), stolen_in(0), stolen_out(0), cancelled(0) { }
+
+    // neither processing nor waiting for the DB
+    [[nodiscard]] bool idle() const {
+        return !phase && !waiting;
+    }
+
+    // jobs not sent to the DB yet, the one being processed included
+    [[nodiscard]] std::size_t queued() const {
+        return job_queue.size() + (phase && !waiting ? 1 : 0);
+    }
 };
 
 #ifndef NO_LOGGING
 std::ostream& operator<<(std::ostream &out, const serverState& state) {
     out << "{phase: " << (state.phase ? "active" : "passive") << ", waiting: " << (state.waiting ? "true" : "false")
-    << ", queue_size: " << state.job_queue.size() << ", current_job: " << state.current_job_id << "}";
+    << ", queue_size: " << state.queued() << ", current_job: " << state.current.item << ", jobs_done: " << state.jobs_done << ", status: " << statusName(state.status) << "}";
     return out;
 }
 #endif
@@ -37,32 +105,75 @@ class server : public Atomic<serverState> {
     public:
     
     // Declare input and output ports
-    Port<int> server_in;      
-    Port<int> server_in_db;     
-    Port<int> server_out1;  
-    Port<int> server_out2;      
+    Port<job> server_in;      
+    Port<job> server_in_db;     // DB acknowledgments, of the query in progress or of stale ones
+    Port<int> server_in_ctrl;   // serverStatus commands (crash, drain, recover)
+    Port<int> server_in_steal;  // id of an idle peer to give the next queued job to (work stealing)
+    Port<queuedJob> server_in_stolen;   // jobs given by peers; only the ones for this server are taken
+    Port<job> server_in_cancel;         // hedged jobs finished elsewhere: the copy held here is dropped
+    Port<job> server_out1;  
+    Port<job> server_out2;      
+    Port<queuedJob> server_out_stolen;  // jobs given to peers
+    Port<int> server_out_refused;       // thieves of the steals that found no queued job, so that the move is undone
+    Port<job> server_out_cancelled;     // copies dropped after a cancel, so the job counters see them leave
     
     int server_id;           
     mutable double processing_time;  
-    mutable int pid_sent;   
     mutable std::ofstream log_file;
     mutable std::mt19937 rng;                          // random number generator
     mutable std::exponential_distribution<double> dist; // exponential distribution
+    double mean_time;                                   // mean processing time at speed 1
+    distributionType service_type;
+    double speed;                                       // relative capacity, processing times are divided by it
+    queueConfig queueing;                               // order in which the queued classes are served
+    cacheConfig caching;                                // session cache, hits are processed faster
+    double steal_cost;                                  // added to the processing time of a stolen job
+    mutable standinClient standin;                      // local process doing the processing (load tests), none by default
+    mutable latencyStats standin_time;                  // wall-clock time of the stand-in calls
+    mutable int standin_failures = 0;                   // calls that fell back to a sampled processing time
     
 
     double getProcessingTime() const {
-        return fabs(dist(rng));
+        return (service_type == distributionType::exponential ? fabs(dist(rng)) : mean_time) / speed;
+    }
+
+    // processing time of a job done by the stand-in: the wall-clock time of the call. In real
+    // time the call has already taken that long, so the job finishes when the answer arrives.
+    double callStandin(const serverState& state) const {
+        double elapsed = standin.call(state.current.item);
+        if (elapsed >= 0) {
+            standin_time.add(elapsed);
+            return elapsed;
+        }
+        standin_failures++;
+        std::cout << state.current_time << "\tServer " << server_id << " could not reach its stand-in for job# " << state.current.item << ", sampled time used" << std::endl;
+        if (log_file.is_open()) {
+            log_file << state.current_time << "\tServer " << server_id << " could not reach its stand-in for job# " << state.current.item << ", sampled time used" << std::endl;
+        }
+        return getProcessingTime();
     }
     
-    explicit server(const std::string& id, int sid, double mean, const std::string& log_path = "")  : Atomic<serverState>(id, serverState()),  server_id(sid),  processing_time(0), pid_sent(0), rng(std::random_device{}()), dist(1.0 / mean) 
+    explicit server(const std::string& id, int sid, double mean, const std::string& log_path = "", unsigned int seed = std::random_device{}(), distributionType type = distributionType::exponential, double spd = 1.0, const queueConfig& queue_config = queueConfig(), const cacheConfig& cache_config = cacheConfig(), double steal_time = 0.0,
+                    const standinConfig& standin_config = standinConfig(), std::size_t timeline_windows = 0)
+        : Atomic<serverState>(id, serverState()),  server_id(sid),  processing_time(0), rng(seed), dist(1.0 / mean), mean_time(mean), service_type(type), speed(spd), queueing(queue_config), caching(cache_config),
+          steal_cost(steal_time), standin(standin_config)
     {  
+        state.cache = lruCache(caching.size);
+        state.completions = timeline(60.0, timeline_windows);
 
-        server_in = addInPort<int>("server_in");
-        server_in_db = addInPort<int>("server_in_db");
+        server_in = addInPort<job>("server_in");
+        server_in_db = addInPort<job>("server_in_db");
+        server_in_ctrl = addInPort<int>("server_in_ctrl");
+        server_in_steal = addInPort<int>("server_in_steal");
+        server_in_stolen = addInPort<queuedJob>("server_in_stolen");
+        server_in_cancel = addInPort<job>("server_in_cancel");
         
  
-        server_out1 = addOutPort<int>("server_out1");
-        server_out2 = addOutPort<int>("server_out2");
+        server_out1 = addOutPort<job>("server_out1");
+        server_out2 = addOutPort<job>("server_out2");
+        server_out_stolen = addOutPort<queuedJob>("server_out_stolen");
+        server_out_refused = addOutPort<int>("server_out_refused");
+        server_out_cancelled = addOutPort<job>("server_out_cancelled");
         
    
         std::string path = log_path.empty() ? "simulation_results/server_log.txt" : log_path;
@@ -73,29 +184,88 @@ class server : public Atomic<serverState> {
         }
     }
 
+    // applies a crash, drain or recover command
+    void setStatus(serverState& state, serverStatus status) const {
+
+        if (status == serverStatus::down && state.status != serverStatus::down) {
+            int lost = static_cast<int>(state.job_queue.size()) + (state.idle() ? 0 : 1);
+            state.lost_jobs += lost;
+            if (state.waiting) {
+                state.stale_acks.push_back(state.current.item.id);
+            } else if (state.phase) {
+                state.busy_time -= state.sigma;  // processing cut short
+            }
+            state.job_queue.clear();
+            state.waiting = false;
+            state.phase = false;
+            state.sigma = std::numeric_limits<double>::infinity();
+            std::cout << state.current_time << "\tServer " << server_id << " crashes, " << lost << " jobs lost" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tServer " << server_id << " crashes, " << lost << " jobs lost" << std::endl;
+            }
+        } else if (status != state.status) {
+            std::cout << state.current_time << "\tServer " << server_id << " is " << statusName(status) << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tServer " << server_id << " is " << statusName(status) << std::endl;
+            }
+        }
+        state.status = status;
+    }
+
+    // starts processing the next queued job; a session cache hit shortens the processing
+    void startNext(serverState& state) const {
+        state.current = state.job_queue.pop(queueing);
+        processing_time = standin.enabled() ? callStandin(state) : getProcessingTime();
+        const char* cached = "";
+        if (caching.enabled()) {
+            if (state.cache.access(state.current.item.affinityKey())) {
+                state.cache_hits++;
+                processing_time *= caching.hit_factor;
+                cached = " (cache hit)";
+            } else {
+                state.cache_misses++;
+                cached = " (cache miss)";
+            }
+        }
+        if (state.current.stolen) {
+            processing_time += steal_cost;
+        }
+        std::cout << state.current_time << "\tServer " << server_id << " starts processing job# " << state.current.item << cached << std::endl;
+        if (log_file.is_open()) {
+            log_file << state.current_time << "\tServer " << server_id << " starts processing job# " << state.current.item << cached << std::endl;
+        }
+        state.phase = true;
+        state.busy_time += processing_time;
+        state.sigma = processing_time;
+    }
+
     // internal transition
     void internalTransition(serverState& state) const override {
 
-        if (!state.waiting && !state.job_queue.empty()) {
-            state.job_queue.pop();
+        double dt = nextEvent(state);
+        state.handing_over.clear();
+        state.refusing.clear();
+        state.cancelling.clear();
+        if (!state.phase || state.sigma > dt) {
+            // only jobs handed over to peers, refused steals or cancellations
+            if (state.phase) {
+                state.sigma -= dt;
+            }
+            return;
+        }
+
+        if (state.waiting) {
+            state.jobs_done++;
+            state.latency[state.current.item.job_class].add(state.current_time - state.current.arrival);
+            state.completions.add(state.current_time);
         }
         
         state.waiting = !state.waiting;
+        state.phase = false;
+        state.sigma = std::numeric_limits<double>::infinity();
         
         if (!state.waiting && !state.job_queue.empty()) {
-            state.current_job_id = state.job_queue.front();
-            std::cout << state.current_time << "\tServer " << server_id << " starts processing job# " << state.current_job_id << std::endl;
-            if (log_file.is_open()) {
-                log_file << state.current_time << "\tServer " << server_id << " starts processing job# " << state.current_job_id << std::endl;
-            }
-            state.phase = true;
-            processing_time = getProcessingTime();
-            state.sigma = processing_time;
-            
-        } else {
-
-            state.phase = false;
-            state.sigma = std::numeric_limits<double>::infinity();
+            startNext(state);
         }
     }
 
@@ -108,37 +278,104 @@ class server : public Atomic<serverState> {
             state.sigma -= e;
         }
         
-        auto in_messages = server_in->getBag();
-        auto in_db_messages = server_in_db->getBag();
-        
-        if (!in_messages.empty()) {
-            int job = in_messages.back();
-            state.job_queue.push(job);
+        for (const auto& msg : server_in_ctrl->getBag()) {
+            setStatus(state, static_cast<serverStatus>(msg));
+        }
+
+        for (const auto& msg : server_in->getBag()) {
+            if (state.status == serverStatus::down) {
+                state.lost_jobs++;
+                std::cout << state.current_time << "\tServer " << server_id << " is down and drops job# " << msg << std::endl;
+                if (log_file.is_open()) {
+                    log_file << state.current_time << "\tServer " << server_id << " is down and drops job# " << msg << std::endl;
+                }
+                continue;
+            }
+
+            state.job_queue.push(msg.job_class, queuedJob{msg, state.current_time});
             
-            std::cout << state.current_time << "\tServer " << server_id << " receives job# " << job << " at server_in1" << std::endl;
+            std::cout << state.current_time << "\tServer " << server_id << " receives job# " << msg << " at server_in1" << std::endl;
             if (log_file.is_open()) {
-                log_file << state.current_time << "\tServer " << server_id << " receives job# " << job << " at server_in1" << std::endl;
+                log_file << state.current_time << "\tServer " << server_id << " receives job# " << msg << " at server_in1" << std::endl;
             }
             
-            if (state.job_queue.size() == 1 && !state.waiting) {
-                state.current_job_id = job;
-                std::cout << state.current_time << "\tServer " << server_id << " starts processing job# " << job << std::endl;
-                if (log_file.is_open()) {
-                    log_file << state.current_time << "\tServer " << server_id << " starts processing job# " << job << std::endl;
+            if (state.idle()) {
+                startNext(state);
+            }
+        }
+
+        for (const auto& msg : server_in_stolen->getBag()) {
+            if (msg.item.server != server_id) {
+                continue;
+            }
+            if (state.status == serverStatus::down) {
+                state.lost_jobs++;
+                continue;
+            }
+            queuedJob stolen = msg;
+            stolen.item.server = 0;
+            stolen.stolen = true;
+            state.job_queue.push(stolen.item.job_class, stolen);
+            state.stolen_in++;
+
+            std::cout << state.current_time << "\tServer " << server_id << " receives stolen job# " << stolen.item << " at server_in_stolen" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tServer " << server_id << " receives stolen job# " << stolen.item << " at server_in_stolen" << std::endl;
+            }
+
+            if (state.idle()) {
+                startNext(state);
+            }
+        }
+
+        // before the steal requests, so that a cancelled copy is not handed over
+        for (const auto& msg : server_in_cancel->getBag()) {
+            if (state.job_queue.remove(msg.job_class, [&msg](const queuedJob& queued) { return queued.item.id == msg.id; })) {
+                state.cancelling.push_back(msg);
+                state.cancelled++;
+            } else if (state.current.item.id == msg.id && state.phase != state.waiting) {
+                // in service (cut short) or waiting for the DB (its acknowledgment is ignored);
+                // a copy that just got its acknowledgment finishes at the same time as the winner
+                if (state.waiting) {
+                    state.stale_acks.push_back(msg.id);
+                    state.waiting = false;
+                } else {
+                    state.busy_time -= state.sigma;
+                    state.phase = false;
+                    state.sigma = std::numeric_limits<double>::infinity();
+                }
+                state.cancelling.push_back(msg);
+                state.cancelled++;
+                if (!state.job_queue.empty()) {
+                    startNext(state);
                 }
-                state.phase = true;  
-                processing_time = getProcessingTime();
-                state.sigma = processing_time;
             }
         }
+
+        for (const auto& thief : server_in_steal->getBag()) {
+            if (state.job_queue.empty()) {
+                state.refusing.push_back(thief);
+                continue;
+            }
+            queuedJob given = state.job_queue.pop(queueing);
+            given.item.server = thief;
+            state.handing_over.push_back(given);
+            state.stolen_out++;
+        }
         
-        if (!in_db_messages.empty() && state.waiting) {
-            std::cout << state.current_time << "\tServer " << server_id << " receives DB acknowledgment for job# " << pid_sent << " at server_in_db" << std::endl;
-            if (log_file.is_open()) {
-                log_file << state.current_time << "\tServer " << server_id << " receives DB acknowledgment for job# " << pid_sent << " at server_in_db" << std::endl;
+        // a batch of the DB can acknowledge a stale query and the one in progress in the same bag
+        for (const auto& msg : server_in_db->getBag()) {
+            auto stale = std::find(state.stale_acks.begin(), state.stale_acks.end(), msg.id);
+            if (stale != state.stale_acks.end()) {
+                state.stale_acks.erase(stale);  // acknowledgment of a job lost in a crash or cancelled
+            } else if (state.waiting && msg.id == state.current.item.id) {
+                std::cout << state.current_time << "\tServer " << server_id << " receives DB acknowledgment for job# " << state.current.item << " at server_in_db" << std::endl;
+                if (log_file.is_open()) {
+                    log_file << state.current_time << "\tServer " << server_id << " receives DB acknowledgment for job# " << state.current.item << " at server_in_db" << std::endl;
+                }
+                state.phase = true;
+                state.sigma = 0.0;
             }
-            state.phase = true;  
-            state.sigma = 0.0;   
         }
     }
 
@@ -146,28 +383,211 @@ class server : public Atomic<serverState> {
     // output function
     void output(const serverState& state) const override {
 
-        state.current_time += state.sigma;
+        double dt = nextEvent(state);
+        state.current_time += dt;
+
+        for (const auto& given : state.handing_over) {
+            std::cout << state.current_time << "\tServer " << server_id << " gives job# " << given.item << " to server " << given.item.server << " at server_out_stolen" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tServer " << server_id << " gives job# " << given.item << " to server " << given.item.server << " at server_out_stolen" << std::endl;
+            }
+            server_out_stolen->addMessage(given);
+        }
+        for (const auto& thief : state.refusing) {
+            std::cout << state.current_time << "\tServer " << server_id << " has no queued job for server " << thief << " at server_out_refused" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tServer " << server_id << " has no queued job for server " << thief << " at server_out_refused" << std::endl;
+            }
+            server_out_refused->addMessage(thief);
+        }
+        for (const auto& dropped : state.cancelling) {
+            std::cout << state.current_time << "\tServer " << server_id << " cancels job# " << dropped << " at server_out_cancelled" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tServer " << server_id << " cancels job# " << dropped << " at server_out_cancelled" << std::endl;
+            }
+            server_out_cancelled->addMessage(dropped);
+        }
+        if (!state.phase || state.sigma > dt) {
+            return;
+        }
         
+        const job& current = state.current.item;
         if (state.waiting) {
             
-            std::cout << state.current_time << "\tServer " << server_id << " finishes job# " << pid_sent << " at server_out1" << std::endl;
+            std::cout << state.current_time << "\tServer " << server_id << " finishes job# " << current << " at server_out1" << std::endl;
             if (log_file.is_open()) {
-                log_file << state.current_time << "\tServer " << server_id << " finishes job# " << pid_sent << " at server_out1" << std::endl;
+                log_file << state.current_time << "\tServer " << server_id << " finishes job# " << current << " at server_out1" << std::endl;
             }
-            server_out1->addMessage(pid_sent);
+            server_out1->addMessage(current);
         } else {
            
-            pid_sent = state.job_queue.front();
-            std::cout << state.current_time << "\tServer " << server_id << " sends job# " << pid_sent << " to database server at server_out2" << std::endl;
+            std::cout << state.current_time << "\tServer " << server_id << " sends job# " << current << " to database server at server_out2" << std::endl;
             if (log_file.is_open()) {
-                log_file << state.current_time << "\tServer " << server_id << " sends job# " << pid_sent << " to database server at server_out2" << std::endl;
+                log_file << state.current_time << "\tServer " << server_id << " sends job# " << current << " to database server at server_out2" << std::endl;
             }
-            server_out2->addMessage(server_id);  
+            job sent = current;
+            sent.server = server_id;
+            server_out2->addMessage(sent);
         }
     }
     
+    // checkpoint: writes the state, the job in flight and the RNG as seen at simulation time t
+    void save(std::ostream& os, const serverState& state, double t) const {
+        snapshot::write(os, state.phase);
+        snapshot::write(os, state.waiting);
+        state.job_queue.save(os);
+        state.current.save(os);
+        snapshot::write(os, snapshot::remaining(state.sigma, state.current_time, t));
+        snapshot::write(os, state.jobs_done);
+        snapshot::write(os, state.busy_time);
+        snapshot::write(os, state.status);
+        snapshot::write(os, state.lost_jobs);
+        snapshot::write(os, state.stale_acks);
+        snapshot::write(os, state.latency);
+        snapshot::write(os, state.completions.getWindow());
+        snapshot::write(os, state.completions.getCounts());
+        state.cache.save(os);
+        snapshot::write(os, state.cache_hits);
+        snapshot::write(os, state.cache_misses);
+        snapshot::write(os, static_cast<std::uint64_t>(state.handing_over.size()));
+        for (const auto& given : state.handing_over) {
+            given.save(os);
+        }
+        snapshot::write(os, state.stolen_in);
+        snapshot::write(os, state.stolen_out);
+        snapshot::write(os, state.refusing);
+        snapshot::write(os, static_cast<std::uint64_t>(state.cancelling.size()));
+        for (const auto& dropped : state.cancelling) {
+            dropped.save(os);
+        }
+        snapshot::write(os, state.cancelled);
+        snapshot::write(os, processing_time);
+        snapshot::writeEngine(os, rng);
+        snapshot::writeEngine(os, dist);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, serverState& state, double t) const {
+        state.current_time = t;
+        return snapshot::read(is, state.phase) && snapshot::read(is, state.waiting)
+            && state.job_queue.restore(is) && state.current.restore(is)
+            && snapshot::read(is, state.sigma) && snapshot::read(is, state.jobs_done) && snapshot::read(is, state.busy_time)
+            && snapshot::read(is, state.status) && snapshot::read(is, state.lost_jobs) && snapshot::read(is, state.stale_acks)
+            && snapshot::read(is, state.latency) && readTimeline(is, state.completions)
+            && state.cache.restore(is) && snapshot::read(is, state.cache_hits) && snapshot::read(is, state.cache_misses)
+            && readHandingOver(is, state.handing_over) && snapshot::read(is, state.stolen_in) && snapshot::read(is, state.stolen_out)
+            && snapshot::read(is, state.refusing)
+            && readCancelling(is, state.cancelling) && snapshot::read(is, state.cancelled)
+            && snapshot::read(is, processing_time)
+            && snapshot::readEngine(is, rng) && snapshot::readEngine(is, dist);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
+    static bool readHandingOver(std::istream& is, std::vector<queuedJob>& handing_over) {
+        std::uint64_t size = 0;
+        if (!snapshot::read(is, size)) {
+            return false;
+        }
+        handing_over.assign(size, queuedJob{});
+        for (auto& given : handing_over) {
+            if (!given.restore(is)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool readCancelling(std::istream& is, std::vector<job>& cancelling) {
+        std::uint64_t size = 0;
+        if (!snapshot::read(is, size)) {
+            return false;
+        }
+        cancelling.assign(size, job{});
+        for (auto& dropped : cancelling) {
+            if (!dropped.restore(is)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool readTimeline(std::istream& is, timeline& completions) {
+        double window = 0.0;
+        if (!snapshot::read(is, window)) {
+            return false;
+        }
+        completions = timeline(window, completions.getLimit());
+        return snapshot::read(is, completions.getCounts());
+    }
+
+    // summary of the jobs finished and lost, and of the utilisation over [0, t]
+    void report(std::ostream& os, const serverState& state, double t) const {
+        os << "server " << server_id << " (speed " << speed << ", " << statusName(state.status) << "): jobs done " << state.jobs_done
+           << ", lost " << state.lost_jobs << ", queued " << state.queued()
+           << ", utilisation " << (t > 0 ? 100.0 * state.busy_time / t : 0.0) << "%";
+        if (caching.enabled()) {
+            int lookups = state.cache_hits + state.cache_misses;
+            os << ", cache hits " << (lookups > 0 ? 100.0 * state.cache_hits / lookups : 0.0) << "%";
+        }
+        if (state.stolen_in > 0 || state.stolen_out > 0) {
+            os << ", stolen " << state.stolen_in << ", given " << state.stolen_out;
+        }
+        if (state.cancelled > 0) {
+            os << ", cancelled " << state.cancelled;
+        }
+        if (standin.enabled()) {
+            os << ", stand-in calls " << standin_time.getCount() << " (failed " << standin_failures << "): ";
+            standin_time.print(os);
+        }
+        os << std::endl;
+    }
+
+    void report(std::ostream& os, double t) const {
+        report(os, state, t);
+    }
+
+    // adds the latencies and completions of this server to pool-wide statistics
+    void collect(const serverState& state, std::array<latencyStats, job::MAX_CLASSES>& latency, timeline& completions, int& lost) const {
+        for (int c = 0; c < job::MAX_CLASSES; c++) {
+            latency[c].merge(state.latency[c]);
+        }
+        completions.merge(state.completions);
+        lost += state.lost_jobs;
+    }
+
+    void collect(std::array<latencyStats, job::MAX_CLASSES>& latency, timeline& completions, int& lost) const {
+        collect(state, latency, completions, lost);
+    }
+
+    // adds this server, named name, and its latencies to a metrics sample
+    void sample(metricsSample& m, const serverState& state, const std::string& name) const {
+        m.servers.push_back({name, static_cast<int>(state.queued()), state.jobs_done, state.lost_jobs, state.busy_time, state.status != serverStatus::down});
+        for (const auto& l : state.latency) {
+            m.latency.merge(l);
+        }
+    }
+
+    void sample(metricsSample& m, const std::string& name) const {
+        sample(m, state, name);
+    }
+
     // time_advance function
     [[nodiscard]] double timeAdvance(const serverState& state) const override {
+        return nextEvent(state);
+    }
+
+    // time to the next output: jobs to hand over, refused steals and cancellations go at once, otherwise the end of the processing or the DB acknowledgment
+    [[nodiscard]] static double nextEvent(const serverState& state) {
+        if (!state.handing_over.empty() || !state.refusing.empty() || !state.cancelling.empty()) {
+            return 0.0;
+        }
         if (!state.phase) {
             return std::numeric_limits<double>::infinity();  // passive
         }
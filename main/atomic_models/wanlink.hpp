@@ -0,0 +1,318 @@
+#ifndef WANLINK_HPP
+#define WANLINK_HPP
+
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <deque>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <algorithm>
+#include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/job.hpp"
+#include "../utils/stats.hpp"
+#include "../utils/distribution.hpp"
+
+using namespace cadmium;
+
+// Network between two models, one way
+struct linkConfig {
+    double latency = 0;                                  // mean propagation time of a job
+    distributionType type = distributionType::constant;  // exponential: propagation times vary and jobs may overtake each other
+    double bandwidth = 0;                                // size units sent per unit of time, 0 for no serialisation delay
+    std::array<double, job::MAX_CLASSES> size = {1, 1, 1, 1};  // size of the jobs of each class
+    int capacity = 0;                                    // jobs on the link at once (sent or being sent), 0 for no limit
+
+    [[nodiscard]] bool enabled() const {
+        return latency > 0 || bandwidth > 0 || capacity > 0;
+    }
+};
+
+// A job in the link: time of arrival while it waits to be sent, time of delivery once on the wire
+struct transit {
+    job item;
+    double time;
+
+    void save(std::ostream& os) const {
+        item.save(os);
+        snapshot::write(os, time);
+    }
+
+    bool restore(std::istream& is) {
+        return item.restore(is) && snapshot::read(is, time);
+    }
+};
+
+struct wanlinkState {
+
+    std::deque<transit> queue;  // jobs waiting for the sender (bandwidth) or for room on the link (capacity)
+    std::vector<transit> wire;  // jobs being sent or propagating, by time of delivery
+    double sender_free;         // time at which the current job is sent
+    int delivered;
+    double busy_time;           // time spent sending
+    latencyStats wait;          // time spent in the queue
+    int max_queue;
+    std::vector<job> cancelling;  // jobs dropped after a cancel, reported at the next output
+    int cancelled;
+    mutable double current_time;
+
+    explicit wanlinkState() : sender_free(0.0), delivered(0), busy_time(0.0), max_queue(0), cancelled(0), current_time(0.0) { }
+};
+
+#ifndef NO_LOGGING
+std::ostream& operator<<(std::ostream &out, const wanlinkState& state) {
+    out << "{queued: " << state.queue.size() << ", in_transit: " << state.wire.size() << ", delivered: " << state.delivered << "}";
+    return out;
+}
+#endif
+
+// Delays every job it receives on wanlink_in and delivers it on wanlink_out. A job
+// first waits until the link carries fewer than `capacity` jobs and the previous
+// job has been sent, then takes size / bandwidth to send (serialisation) and the
+// latency of the link to propagate. With a constant latency jobs keep their order,
+// with exponential propagation times a job can overtake another. A job received on
+// wanlink_in_cancel is dropped from the queue or the wire and reported on
+// wanlink_out_cancelled, so a hedged copy still in transit is cancelled too.
+class wanlink : public Atomic<wanlinkState> {
+    public:
+
+    Port<job> wanlink_in;
+    Port<job> wanlink_in_cancel;      // jobs finished elsewhere: the copy in transit is dropped
+    Port<job> wanlink_out;
+    Port<job> wanlink_out_cancelled;  // copies dropped after a cancel
+
+    linkConfig config;
+
+    mutable std::ofstream log_file;
+    mutable std::mt19937 rng;                             // random number generator
+    mutable std::exponential_distribution<double> dist;   // propagation time (exponential links)
+
+    explicit wanlink(const std::string& id, const linkConfig& cfg, const std::string& log_path = "simulation_results/wanlink_log.txt", unsigned int seed = std::random_device{}())
+        : Atomic<wanlinkState>(id, wanlinkState()), config(cfg), rng(seed), dist(cfg.latency > 0 ? 1.0 / cfg.latency : 1.0)
+    {
+        wanlink_in = addInPort<job>("wanlink_in");
+        wanlink_in_cancel = addInPort<job>("wanlink_in_cancel");
+        wanlink_out = addOutPort<job>("wanlink_out");
+        wanlink_out_cancelled = addOutPort<job>("wanlink_out_cancelled");
+
+        log_file.open(log_path, std::ios::app);
+        if (!log_file.is_open()) {
+            std::cerr << "Warning: Could not open log file: " << log_path << std::endl;
+        }
+    }
+
+    // propagation time of the next job
+    double transitTime() const {
+        if (config.type == distributionType::exponential && config.latency > 0) {
+            return dist(rng);
+        }
+        return config.latency;
+    }
+
+    // time to send a job of the given class
+    [[nodiscard]] double sendTime(const job& item) const {
+        if (config.bandwidth <= 0) {
+            return 0.0;
+        }
+        int cls = std::clamp(item.job_class, 0, job::MAX_CLASSES - 1);
+        return config.size[cls] / config.bandwidth;
+    }
+
+    // puts the queued jobs on the wire while the sender is free and the link has room
+    void send(wanlinkState& state) const {
+        while (!state.queue.empty() && senderFree(state) && (config.capacity <= 0 || static_cast<int>(state.wire.size()) < config.capacity)) {
+            const transit& next = state.queue.front();
+            double sent = std::max(state.sender_free, state.current_time) + sendTime(next.item);
+            state.busy_time += sent - std::max(state.sender_free, state.current_time);
+            state.sender_free = sent;
+            state.wait.add(state.current_time - next.time);
+            transit t{next.item, sent + transitTime()};
+            auto pos = std::upper_bound(state.wire.begin(), state.wire.end(), t.time, [](double d, const transit& other) { return d < other.time; });
+            state.wire.insert(pos, t);
+            state.queue.pop_front();
+        }
+    }
+
+    // internal transition
+    void internalTransition(wanlinkState& state) const override {
+        state.cancelling.clear();
+        auto end = std::find_if(state.wire.begin(), state.wire.end(), [&state](const transit& t) { return !due(t.time, state); });
+        state.delivered += static_cast<int>(end - state.wire.begin());
+        state.wire.erase(state.wire.begin(), end);
+        send(state);
+    }
+
+    // external transition
+    void externalTransition(wanlinkState& state, double e) const override {
+
+        state.current_time += e;
+
+        for (const auto& msg : wanlink_in->getBag()) {
+            state.queue.push_back({msg, state.current_time});
+        }
+        for (const auto& msg : wanlink_in_cancel->getBag()) {
+            auto same = [&msg](const transit& t) { return t.item.id == msg.id; };
+            auto queued = std::find_if(state.queue.begin(), state.queue.end(), same);
+            if (queued != state.queue.end()) {
+                state.queue.erase(queued);
+            } else {
+                auto sent = std::find_if(state.wire.begin(), state.wire.end(), same);
+                if (sent == state.wire.end()) {
+                    continue;
+                }
+                state.wire.erase(sent);  // a job being serialised keeps the sender busy until it would have been sent
+            }
+            state.cancelling.push_back(msg);
+            state.cancelled++;
+        }
+        send(state);
+        state.max_queue = std::max(state.max_queue, static_cast<int>(state.queue.size()));
+    }
+
+    // output function
+    void output(const wanlinkState& state) const override {
+
+        state.current_time += timeAdvance(state);
+
+        for (const auto& dropped : state.cancelling) {
+            std::cout << state.current_time << "\t" << getId() << " cancels job# " << dropped << " at wanlink_out_cancelled" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\t" << getId() << " cancels job# " << dropped << " at wanlink_out_cancelled" << std::endl;
+            }
+            wanlink_out_cancelled->addMessage(dropped);
+        }
+        for (std::size_t k = 0; k < state.wire.size() && due(state.wire[k].time, state); k++) {
+            std::cout << state.current_time << "\t" << getId() << " delivers job# " << state.wire[k].item << " at wanlink_out" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\t" << getId() << " delivers job# " << state.wire[k].item << " at wanlink_out" << std::endl;
+            }
+            wanlink_out->addMessage(state.wire[k].item);
+        }
+    }
+
+    // checkpoint: writes the state and the RNG as seen at simulation time t
+    void save(std::ostream& os, const wanlinkState& state, [[maybe_unused]] double t) const {
+        snapshot::write(os, static_cast<std::uint64_t>(state.queue.size()));
+        for (const auto& t_job : state.queue) {
+            t_job.save(os);
+        }
+        snapshot::write(os, static_cast<std::uint64_t>(state.wire.size()));
+        for (const auto& t_job : state.wire) {
+            t_job.save(os);
+        }
+        snapshot::write(os, state.sender_free);
+        snapshot::write(os, state.delivered);
+        snapshot::write(os, state.busy_time);
+        snapshot::write(os, state.wait);
+        snapshot::write(os, state.max_queue);
+        snapshot::write(os, static_cast<std::uint64_t>(state.cancelling.size()));
+        for (const auto& dropped : state.cancelling) {
+            dropped.save(os);
+        }
+        snapshot::write(os, state.cancelled);
+        snapshot::writeEngine(os, rng);
+        snapshot::writeEngine(os, dist);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, wanlinkState& state, double t) const {
+        state.current_time = t;
+        std::uint64_t size = 0;
+        if (!snapshot::read(is, size)) {
+            return false;
+        }
+        state.queue.assign(size, transit{});
+        for (auto& t_job : state.queue) {
+            if (!t_job.restore(is)) {
+                return false;
+            }
+        }
+        if (!snapshot::read(is, size)) {
+            return false;
+        }
+        state.wire.assign(size, transit{});
+        for (auto& t_job : state.wire) {
+            if (!t_job.restore(is)) {
+                return false;
+            }
+        }
+        if (!snapshot::read(is, state.sender_free) || !snapshot::read(is, state.delivered) || !snapshot::read(is, state.busy_time)
+            || !snapshot::read(is, state.wait) || !snapshot::read(is, state.max_queue) || !snapshot::read(is, size)) {
+            return false;
+        }
+        state.cancelling.assign(size, job{});
+        for (auto& dropped : state.cancelling) {
+            if (!dropped.restore(is)) {
+                return false;
+            }
+        }
+        return snapshot::read(is, state.cancelled) && snapshot::readEngine(is, rng) && snapshot::readEngine(is, dist);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
+    // summary of the jobs carried over [0, t]
+    void report(std::ostream& os, const wanlinkState& state, double t) const {
+        os << getId() << " (latency " << config.latency << "): delivered " << state.delivered;
+        if (config.bandwidth > 0) {
+            os << ", utilisation " << (t > 0 ? 100.0 * std::min(state.busy_time, t) / t : 0.0) << "%";
+        }
+        if (state.cancelled > 0) {
+            os << ", cancelled " << state.cancelled;
+        }
+        os << ", max queue " << state.max_queue << ", queue wait: ";
+        state.wait.print(os);
+        os << std::endl;
+    }
+
+    void report(std::ostream& os, double t) const {
+        report(os, state, t);
+    }
+
+    // time_advance function: at once to report cancellations, otherwise until the next delivery
+    // or until the sender can take the next queued job
+    [[nodiscard]] double timeAdvance(const wanlinkState& state) const override {
+        if (!state.cancelling.empty()) {
+            return 0.0;
+        }
+        double next = std::numeric_limits<double>::infinity();
+        if (!state.wire.empty()) {
+            next = state.wire.front().time;
+        }
+        if (!state.queue.empty() && !senderFree(state) && (config.capacity <= 0 || static_cast<int>(state.wire.size()) < config.capacity)) {
+            next = std::min(next, state.sender_free);
+        }
+        return std::max(0.0, next - state.current_time);
+    }
+
+    // destructor to close log file
+    ~wanlink() {
+        if (log_file.is_open()) {
+            log_file.close();
+        }
+    }
+
+    private:
+
+    // event times are absolute, current_time is accumulated from the time advances
+    static bool due(double time, const wanlinkState& state) {
+        return time <= state.current_time + 1e-9;
+    }
+
+    // true when the sender has finished the previous job
+    static bool senderFree(const wanlinkState& state) {
+        return due(state.sender_free, state);
+    }
+};
+
+#endif
@@ -0,0 +1,263 @@
+#ifndef WORKSTEALER_HPP
+#define WORKSTEALER_HPP
+
+#include <iostream>
+#include <fstream>
+#include <array>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "cadmium/modeling/devs/atomic.hpp"
+#include "../utils/snapshot.hpp"
+#include "../utils/job.hpp"
+#include "../utils/control.hpp"
+
+using namespace cadmium;
+
+struct stealConfig {
+    static constexpr int MAX_SERVERS = 3;
+
+    bool enabled = false;
+    double cost = 0.1;   // added to the processing time of a stolen job (moving its context to the thief)
+    int threshold = 2;   // a server is only robbed while it holds at least this many jobs (one of them in service)
+};
+
+struct workstealerState {
+
+    std::array<int, stealConfig::MAX_SERVERS> outstanding;       // jobs at each server: queued, in service or waiting for the DB
+    std::array<serverStatus, stealConfig::MAX_SERVERS> status;   // last status reported for each server
+    int active;                                                  // servers 1 to active may steal (autoscaling)
+    std::vector<stealRequest> pending;                           // steals sent at the next output
+    std::vector<stealRequest> undoing;                           // steals refused by their victim, undone at the balancer at the next output
+    int steals;
+    int refused;
+    mutable double current_time;
+
+    explicit workstealerState() : outstanding{}, status{}, active(stealConfig::MAX_SERVERS), steals(0), refused(0), current_time(0.0) { }
+};
+
+#ifndef NO_LOGGING
+std::ostream& operator<<(std::ostream &out, const workstealerState& state) {
+    out << "{outstanding: [" << state.outstanding[0] << ", " << state.outstanding[1] << ", " << state.outstanding[2]
+        << "], pending: " << state.pending.size() << ", steals: " << state.steals << "}";
+    return out;
+}
+#endif
+
+// Matches idle servers with the most loaded peer. The jobs at each server are
+// counted from the jobs delivered to it (by the balancer, or by its dispatch link
+// when the network is modelled) and the jobs the servers finish; as soon as a
+// server that may take work has none while a peer holds at least `threshold` jobs,
+// the peer is told on workstealer_out<peer> to hand its next queued job over to
+// the idle server. Each move is also sent to the balancer so that its own
+// outstanding counts stay right. A peer whose queue turned out empty refuses on
+// workstealer_in_refused<peer>, and the move is undone here and at the balancer.
+class workstealer : public Atomic<workstealerState> {
+    public:
+
+    // jobs delivered to each server
+    Port<job> workstealer_in_dispatched1;
+    Port<job> workstealer_in_dispatched2;
+    Port<job> workstealer_in_dispatched3;
+
+    // jobs finished by each server
+    Port<job> workstealer_in_done1;
+    Port<job> workstealer_in_done2;
+    Port<job> workstealer_in_done3;
+
+    // serverStatus of each server (fault injector)
+    Port<int> workstealer_in_health1;
+    Port<int> workstealer_in_health2;
+    Port<int> workstealer_in_health3;
+
+    // id of the thief of a refused steal, from each victim
+    Port<int> workstealer_in_refused1;
+    Port<int> workstealer_in_refused2;
+    Port<int> workstealer_in_refused3;
+
+    // number of active servers (autoscaler)
+    Port<int> workstealer_in_active;
+
+    // id of the thief, to the server that gives a job
+    Port<int> workstealer_out1;
+    Port<int> workstealer_out2;
+    Port<int> workstealer_out3;
+
+    // every move and every undone move (victim and thief swapped), to the balancer
+    Port<stealRequest> workstealer_out_moves;
+
+    stealConfig config;
+    int servers;
+
+    mutable std::ofstream log_file;
+
+    explicit workstealer(const std::string& id, const stealConfig& cfg, int n_servers = 3, int active_servers = 3, const std::string& log_path = "simulation_results/workstealer_log.txt")
+        : Atomic<workstealerState>(id, workstealerState()), config(cfg), servers(n_servers)
+    {
+        state.active = std::clamp(active_servers, 1, servers);
+
+        workstealer_in_dispatched1 = addInPort<job>("workstealer_in_dispatched1");
+        workstealer_in_dispatched2 = addInPort<job>("workstealer_in_dispatched2");
+        workstealer_in_dispatched3 = addInPort<job>("workstealer_in_dispatched3");
+        workstealer_in_done1 = addInPort<job>("workstealer_in_done1");
+        workstealer_in_done2 = addInPort<job>("workstealer_in_done2");
+        workstealer_in_done3 = addInPort<job>("workstealer_in_done3");
+        workstealer_in_health1 = addInPort<int>("workstealer_in_health1");
+        workstealer_in_health2 = addInPort<int>("workstealer_in_health2");
+        workstealer_in_health3 = addInPort<int>("workstealer_in_health3");
+        workstealer_in_refused1 = addInPort<int>("workstealer_in_refused1");
+        workstealer_in_refused2 = addInPort<int>("workstealer_in_refused2");
+        workstealer_in_refused3 = addInPort<int>("workstealer_in_refused3");
+        workstealer_in_active = addInPort<int>("workstealer_in_active");
+
+        workstealer_out1 = addOutPort<int>("workstealer_out1");
+        workstealer_out2 = addOutPort<int>("workstealer_out2");
+        workstealer_out3 = addOutPort<int>("workstealer_out3");
+        workstealer_out_moves = addOutPort<stealRequest>("workstealer_out_moves");
+
+        log_file.open(log_path, std::ios::app);
+        if (!log_file.is_open()) {
+            std::cerr << "Warning: Could not open log file: " << log_path << std::endl;
+        }
+    }
+
+    // pairs every idle server that may take work with the most loaded peer that can give one
+    void match(workstealerState& state) const {
+        for (int thief = 0; thief < state.active; thief++) {
+            if (state.outstanding[thief] != 0 || state.status[thief] != serverStatus::up) {
+                continue;
+            }
+            int victim = -1;
+            for (int i = 0; i < servers; i++) {
+                if (i != thief && state.status[i] != serverStatus::down && state.outstanding[i] >= config.threshold
+                    && (victim < 0 || state.outstanding[i] > state.outstanding[victim])) {
+                    victim = i;
+                }
+            }
+            if (victim >= 0) {
+                state.outstanding[victim]--;
+                state.outstanding[thief]++;
+                state.pending.push_back({victim + 1, thief + 1});
+                state.steals++;
+            }
+        }
+    }
+
+    // internal transition
+    void internalTransition(workstealerState& state) const override {
+        state.pending.clear();
+        state.undoing.clear();
+    }
+
+    // external transition
+    void externalTransition(workstealerState& state, double e) const override {
+
+        state.current_time += e;
+
+        std::array<Port<int>, stealConfig::MAX_SERVERS> health = {workstealer_in_health1, workstealer_in_health2, workstealer_in_health3};
+        std::array<Port<job>, stealConfig::MAX_SERVERS> dispatched = {workstealer_in_dispatched1, workstealer_in_dispatched2, workstealer_in_dispatched3};
+        std::array<Port<job>, stealConfig::MAX_SERVERS> done = {workstealer_in_done1, workstealer_in_done2, workstealer_in_done3};
+        std::array<Port<int>, stealConfig::MAX_SERVERS> refused = {workstealer_in_refused1, workstealer_in_refused2, workstealer_in_refused3};
+        for (int i = 0; i < stealConfig::MAX_SERVERS; i++) {
+            for (const auto& msg : health[i]->getBag()) {
+                auto status = static_cast<serverStatus>(msg);
+                if (status == serverStatus::down || state.status[i] == serverStatus::down) {
+                    state.outstanding[i] = 0;  // the jobs of a crashed server are lost
+                }
+                state.status[i] = status;
+            }
+            state.outstanding[i] += static_cast<int>(dispatched[i]->getBag().size());
+            state.outstanding[i] = std::max(0, state.outstanding[i] - static_cast<int>(done[i]->getBag().size()));
+        }
+        for (int i = 0; i < stealConfig::MAX_SERVERS; i++) {
+            for (const auto& thief : refused[i]->getBag()) {
+                if (state.status[i] != serverStatus::down) {
+                    state.outstanding[i]++;
+                }
+                state.outstanding[thief - 1] = std::max(0, state.outstanding[thief - 1] - 1);
+                state.undoing.push_back({thief, i + 1});
+                state.steals--;
+                state.refused++;
+            }
+        }
+        for (const auto& msg : workstealer_in_active->getBag()) {
+            state.active = std::clamp(msg, 1, servers);
+        }
+
+        match(state);
+    }
+
+    // output function
+    void output(const workstealerState& state) const override {
+
+        std::array<Port<int>, stealConfig::MAX_SERVERS> out = {workstealer_out1, workstealer_out2, workstealer_out3};
+        for (const auto& request : state.pending) {
+            std::cout << state.current_time << "\tWork stealer: server " << request.thief << " steals from server " << request.victim << " at workstealer_out" << request.victim << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tWork stealer: server " << request.thief << " steals from server " << request.victim << " at workstealer_out" << request.victim << std::endl;
+            }
+            out[request.victim - 1]->addMessage(request.thief);
+            workstealer_out_moves->addMessage(request);
+        }
+        for (const auto& undo : state.undoing) {
+            std::cout << state.current_time << "\tWork stealer: server " << undo.thief << " refuses the steal of server " << undo.victim << ", undone at workstealer_out_moves" << std::endl;
+            if (log_file.is_open()) {
+                log_file << state.current_time << "\tWork stealer: server " << undo.thief << " refuses the steal of server " << undo.victim << ", undone at workstealer_out_moves" << std::endl;
+            }
+            workstealer_out_moves->addMessage(undo);
+        }
+    }
+
+    // checkpoint: writes the state as seen at simulation time t
+    void save(std::ostream& os, const workstealerState& state, [[maybe_unused]] double t) const {
+        snapshot::write(os, state.outstanding);
+        snapshot::write(os, state.status);
+        snapshot::write(os, state.active);
+        snapshot::write(os, state.pending);
+        snapshot::write(os, state.undoing);
+        snapshot::write(os, state.steals);
+        snapshot::write(os, state.refused);
+    }
+
+    void save(std::ostream& os, double t) const {
+        save(os, state, t);
+    }
+
+    // checkpoint: reads a state written by save() at simulation time t
+    bool restore(std::istream& is, workstealerState& state, double t) const {
+        state.current_time = t;
+        return snapshot::read(is, state.outstanding) && snapshot::read(is, state.status) && snapshot::read(is, state.active)
+            && snapshot::read(is, state.pending) && snapshot::read(is, state.undoing)
+            && snapshot::read(is, state.steals) && snapshot::read(is, state.refused);
+    }
+
+    bool restore(std::istream& is, double t) {
+        return restore(is, state, t);
+    }
+
+    void report(std::ostream& os, const workstealerState& state) const {
+        os << "work stealer (cost " << config.cost << "): steals " << state.steals;
+        if (state.refused > 0) {
+            os << ", refused " << state.refused;
+        }
+        os << std::endl;
+    }
+
+    void report(std::ostream& os) const {
+        report(os, state);
+    }
+
+    // time_advance function
+    [[nodiscard]] double timeAdvance(const workstealerState& state) const override {
+        return state.pending.empty() && state.undoing.empty() ? std::numeric_limits<double>::infinity() : 0.0;
+    }
+
+    // destructor to close log file
+    ~workstealer() {
+        if (log_file.is_open()) {
+            log_file.close();
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef GLBS_HPP
+#define GLBS_HPP
+
+#include <memory>
+#include <array>
+#include <vector>
+#include <string>
+#include <numeric>
+#include "cadmium/modeling/devs/coupled.hpp"
+#include "../atomic_models/balancer.hpp"
+#include "../atomic_models/wanlink.hpp"
+#include "lbs.hpp"
+
+using namespace cadmium;
+
+// Regional deployment: a global balancer dispatching to one LBS per zone
+struct regionConfig {
+    static constexpr int MAX_ZONES = balancerConfig::MAX_SERVERS;  // the global balancer has three output ports
+    static constexpr unsigned int ZONE_SEEDS = 16;                 // seeds of a zone: its LBS (seed .. seed + 12) and its two links
+
+    int zones = 0;                                         // 0 for a single LBS without a global tier
+    double dispatch_time = 0.01;                           // global balancer dispatch time
+    balancerPolicy policy = balancerPolicy::weighted_least_loaded;  // global dispatch policy
+    std::array<lbsConfig, MAX_ZONES> lbs;                  // pool of each zone
+    std::array<linkConfig, MAX_ZONES> link;                // network between the global balancer and each zone, each way
+
+    [[nodiscard]] bool enabled() const {
+        return zones > 0;
+    }
+
+    // global balancer parameters: one output per zone, weighted by the capacity of its pool. The
+    // hedging tracker runs with no budget, so the balancer measures the end-to-end response time.
+    // It holds at most the jobs its zones hold together.
+    [[nodiscard]] balancerConfig balancer() const {
+        balancerConfig cfg;
+        cfg.dispatch_time = dispatch_time;
+        cfg.servers = zones;
+        cfg.policy = policy;
+        cfg.active_servers = zones;
+        for (int z = 0; z < zones; z++) {
+            cfg.weights[z] = std::accumulate(lbs[z].server_speed.begin(), lbs[z].server_speed.begin() + lbs[z].servers, 0.0);
+            cfg.max_jobs += lbs[z].max_jobs;
+        }
+        cfg.hedging.enabled = true;
+        cfg.hedging.budget = 0;
+        return cfg;
+    }
+};
+
+// Global load balancing system: the global balancer sends each job over the link
+// of a zone to the LBS of that zone; finished jobs come back over the return link
+// of the zone, leave at out and are reported done to the global balancer. Same
+// ports as LBS, so a GLBS takes the place of an LBS in a larger model.
+struct GLBS : public Coupled {
+
+    std::shared_ptr<cadmium::PortInterface> in;
+    std::shared_ptr<cadmium::PortInterface> out;
+
+    // components, kept to checkpoint their state
+    std::shared_ptr<balancer> bal;
+    std::vector<std::shared_ptr<wanlink>> uplink;    // global balancer -> zone
+    std::vector<std::shared_ptr<LBS>> zone;
+    std::vector<std::shared_ptr<wanlink>> downlink;  // zone -> out
+
+    GLBS(const std::string& id, const regionConfig& config, const std::string& log_path = "simulation_results/glbs_log.txt", unsigned int seed = std::random_device{}()) : Coupled(id) {
+
+        in = addInPort<job>("in");
+        out = addOutPort<job>("out");
+
+        // model name, balancer parameters, log path, rng seed (the one the balancer of a single LBS would use)
+        bal = addComponent<balancer>("global_balancer", config.balancer(), log_path, seed + 3 * lbsConfig::MAX_SERVERS + 3);
+
+        // model names, link and pool parameters, log path, rng seeds (a block of ZONE_SEEDS per zone after the base seed)
+        for (int z = 0; z < config.zones; z++) {
+            unsigned int zone_seed = seed + regionConfig::ZONE_SEEDS * (z + 1);
+            std::string name = "zone" + std::to_string(z + 1);
+            uplink.push_back(addComponent<wanlink>(name + "_uplink", config.link[z], log_path, zone_seed + regionConfig::ZONE_SEEDS - 2));
+            zone.push_back(addComponent<LBS>(name, config.lbs[z], log_path, zone_seed));
+            downlink.push_back(addComponent<wanlink>(name + "_downlink", config.link[z], log_path, zone_seed + regionConfig::ZONE_SEEDS - 1));
+        }
+
+        std::array<Port<job>, regionConfig::MAX_ZONES> bal_out = {bal->balancer_out1, bal->balancer_out2, bal->balancer_out3};
+        std::array<Port<job>, regionConfig::MAX_ZONES> bal_done = {bal->balancer_in_done1, bal->balancer_in_done2, bal->balancer_in_done3};
+
+        // external input couplings
+        addCoupling(in, bal->balancer_in);
+
+        // internal and external output couplings
+        for (int z = 0; z < config.zones; z++) {
+            addCoupling(bal_out[z], uplink[z]->wanlink_in);
+            addCoupling(uplink[z]->wanlink_out, zone[z]->in);
+            addCoupling(zone[z]->out, downlink[z]->wanlink_in);
+            addCoupling(downlink[z]->wanlink_out, bal_done[z]);
+            addCoupling(downlink[z]->wanlink_out, out);
+        }
+    }
+
+    // adds the global balancer and every zone (servers named zone/server) to a metrics sample
+    void sample(metricsSample& m) const {
+        bal->sample(m);
+        for (std::size_t z = 0; z < zone.size(); z++) {
+            zone[z]->sample(m, std::to_string(z + 1) + "/");
+        }
+    }
+
+    // summary of the global tier and of every zone at simulation time t
+    void report(std::ostream& os, double t) const {
+        os << "global ";
+        bal->report(os);
+        for (std::size_t z = 0; z < zone.size(); z++) {
+            os << "zone " << z + 1 << " (link " << uplink[z]->config.latency << " s each way):" << std::endl;
+            zone[z]->report(os, t);
+        }
+    }
+
+    // checkpoint: writes the state of every component as seen at simulation time t
+    void save(std::ostream& os, double t) const {
+        snapshot::write(os, static_cast<int>(zone.size()));
+        bal->save(os, t);
+        for (std::size_t z = 0; z < zone.size(); z++) {
+            uplink[z]->save(os, t);
+            zone[z]->save(os, t);
+            downlink[z]->save(os, t);
+        }
+    }
+
+    // checkpoint: reads the states written by save() at simulation time t
+    bool restore(std::istream& is, double t) {
+        int zones = 0;
+        if (!snapshot::read(is, zones) || zones != static_cast<int>(zone.size())) {
+            std::cerr << "Error: snapshot has " << zones << " zones, the model has " << zone.size() << std::endl;
+            return false;
+        }
+        bool ok = bal->restore(is, t);
+        for (std::size_t z = 0; ok && z < zone.size(); z++) {
+            ok = uplink[z]->restore(is, t) && zone[z]->restore(is, t) && downlink[z]->restore(is, t);
+        }
+        return ok;
+    }
+};
+
+#endif
@@ -3,58 +3,428 @@
 
 #include <memory>
 #include <fstream>
+#include <array>
+#include <vector>
+#include <string>
 #include "cadmium/modeling/devs/coupled.hpp"
 #include "../atomic_models/balancer.hpp"
 #include "../atomic_models/server.hpp"
 #include "../atomic_models/dbserver.hpp"
+#include "../atomic_models/faultinjector.hpp"
+#include "../atomic_models/autoscaler.hpp"
+#include "../atomic_models/workstealer.hpp"
+#include "../atomic_models/dbcache.hpp"
+#include "../atomic_models/wanlink.hpp"
+#include "../utils/stats.hpp"
+#include "../utils/job.hpp"
+#include "../utils/classqueue.hpp"
 
 using namespace cadmium;
 
+// LBS parameters; the defaults are the original hard-coded values
+struct lbsConfig {
+    static constexpr int MAX_SERVERS = balancerConfig::MAX_SERVERS;  // the balancer and the db server have three server ports
+
+    double dispatch_time = 1;                                   // balancer dispatch time (mean, per job and worker)
+    int dispatch_workers = 1;                                   // jobs the balancer dispatches in parallel
+    distributionType dispatch_type = distributionType::constant;  // distribution of the balancer dispatch time
+    balancerPolicy policy = balancerPolicy::modulo;             // balancer dispatch policy
+    int servers = MAX_SERVERS;                                  // servers in the pool (1 to MAX_SERVERS)
+    std::array<double, MAX_SERVERS> server_mean = {0.5, 0.5, 0.5};  // mean processing time of each server
+    std::array<double, MAX_SERVERS> server_speed = {1, 1, 1};   // relative capacity of each server, also the balancer weights
+    distributionType service_type = distributionType::exponential;
+    double db_time = 1;                                         // db processing time
+    double health_interval = 0;                                 // balancer health check period, 0 to see status changes at once
+    int hash_replicas = 64;                                     // consistent_hash ring points per server and unit of speed
+    double load_factor = 0;                                     // consistent_hash load bound, 0 for none
+    faultConfig faults;                                         // server outages, none by default
+    autoscalerConfig autoscaling;                               // disabled by default: every server is active
+    queueConfig server_queueing;                                // order in which the servers serve the job classes
+    queueConfig db_queueing;                                    // order in which the db server serves the job classes
+    batchConfig db_batching;                                    // round trips of the db server, one job each by default
+    cacheConfig server_cache;                                   // session cache of each server, none by default
+    stealConfig stealing;                                       // work stealing between the servers, disabled by default
+    hedgeConfig hedging;                                        // balancer duplicates of slow jobs, disabled by default
+    dbCacheConfig db_cache;                                     // cache tier in front of the db server, disabled by default
+    linkConfig dispatch_link;                                   // network from the balancer to each server, instantaneous by default
+    linkConfig db_link;                                         // network from each server to the db server (or its cache), instantaneous by default
+    standinConfig server_standin;                               // local process doing the processing of every server (load tests), none by default
+    int max_jobs = 0;                                           // jobs the pool holds at once, the balancer sheds the others; 0 for no limit
+    std::size_t timeline_windows = 0;                           // completion windows each server keeps, 0 for no limit
+
+    // balancer parameters matching this configuration
+    [[nodiscard]] balancerConfig balancer() const {
+        return balancerConfig{.dispatch_time = dispatch_time, .servers = servers, .policy = policy, .weights = server_speed,
+                              .health_interval = health_interval, .active_servers = autoscaling.enabled ? autoscaling.initial_servers : servers,
+                              .hash_replicas = hash_replicas, .load_factor = load_factor, .hedging = hedging,
+                              .workers = dispatch_workers, .dispatch_type = dispatch_type, .max_jobs = max_jobs};
+    }
+};
+
+// pool-wide summary of the servers: jobs lost, latency (per class when several classes
+// were served) and, when faults are injected, throughput per window
+inline void reportPool(std::ostream& os, const std::array<latencyStats, job::MAX_CLASSES>& latency, const timeline& completions, int lost, bool faults) {
+    latencyStats all;
+    int classes = 0;
+    for (const auto& l : latency) {
+        all.merge(l);
+        classes += l.getCount() > 0 ? 1 : 0;
+    }
+    os << "jobs lost: " << lost << std::endl;
+    os << "server latency: ";
+    all.print(os);
+    os << std::endl;
+    for (int c = 0; c < job::MAX_CLASSES && classes > 1; c++) {
+        if (latency[c].getCount() > 0) {
+            os << "  class " << c << " (" << latency[c].getCount() << " jobs): ";
+            latency[c].print(os);
+            os << std::endl;
+        }
+    }
+    if (faults) {
+        os << "completions per " << completions.getWindow() << " s window:" << std::endl;
+        completions.print(os);
+    }
+}
+
 struct LBS : public Coupled {
 
     std::shared_ptr<cadmium::PortInterface> in;
     std::shared_ptr<cadmium::PortInterface> out;
-    
-    LBS(const std::string& id, const std::string& log_path = "simulation_results/lbs_log.txt") : Coupled(id) {
 
-        
-        // create external input and output ports 
-        in = addInPort<int>("in");
-        out = addOutPort<int>("out");
+    // components, kept to checkpoint their state
+    std::shared_ptr<balancer> bal;
+    std::vector<std::shared_ptr<server>> srv;
+    std::shared_ptr<dbserver> db;
+    std::shared_ptr<faultinjector> inj;  // only when faults are configured
+    std::shared_ptr<autoscaler> scaler;  // only when autoscaling is enabled
+    std::shared_ptr<workstealer> stealer;  // only when work stealing is enabled
+    std::shared_ptr<dbcache> cache;  // only when the db cache is enabled
+    std::vector<std::shared_ptr<wanlink>> dispatch_links;  // balancer -> each server, only when the dispatch link is enabled
+    std::vector<std::shared_ptr<wanlink>> db_links;        // each server -> db, only when the db link is enabled
+
+    LBS(const std::string& id, const std::string& log_path = "simulation_results/lbs_log.txt", unsigned int seed = std::random_device{}()) : LBS(id, lbsConfig(), log_path, seed) { }
+
+    LBS(const std::string& id, const lbsConfig& config, const std::string& log_path = "simulation_results/lbs_log.txt", unsigned int seed = std::random_device{}()) : Coupled(id) {
+
+
+        // create external input and output ports
+        in = addInPort<job>("in");
+        out = addOutPort<job>("out");
 
         // create atomic components
 
-        // model name, dipatch time, log path
-        auto bal = addComponent<balancer>("balancer", 1, log_path);  
+        // model name, balancer parameters, log path, rng seed (after the db link seeds)
+        bal = addComponent<balancer>("balancer", config.balancer(), log_path, seed + 3 * lbsConfig::MAX_SERVERS + 3);
+
+        // model name, server id, mean processing time, log path, rng seed, distribution, speed, queueing, cache, steal cost, stand-in, timeline windows
+        for (int i = 0; i < config.servers; i++) {
+            srv.push_back(addComponent<server>("server" + std::to_string(i + 1), i + 1, config.server_mean[i], log_path, seed + i, config.service_type, config.server_speed[i],
+                                               config.server_queueing, config.server_cache, config.stealing.cost, config.server_standin, config.timeline_windows));
+        }
+
+        // model name, db processing time, log path, queueing, batching
+        db = addComponent<dbserver>("db_server", config.db_time, log_path, config.db_queueing, config.db_batching);
+
+        // model name, faults, number of servers, log path, rng seed (after the generator seed)
+        if (config.faults.enabled()) {
+            inj = addComponent<faultinjector>("fault_injector", config.faults, config.servers, log_path, seed + lbsConfig::MAX_SERVERS + 1);
+        }
+
+        // model name, autoscaling parameters, number of servers, log path
+        if (config.autoscaling.enabled) {
+            scaler = addComponent<autoscaler>("autoscaler", config.autoscaling, config.servers, log_path);
+        }
+
+        // model name, stealing parameters, number of servers, initially active servers, log path
+        if (config.stealing.enabled) {
+            stealer = addComponent<workstealer>("work_stealer", config.stealing, config.servers, config.balancer().active_servers, log_path);
+        }
+
+        // model name, cache parameters, log path, rng seed (after the fault injector seed)
+        if (config.db_cache.enabled) {
+            cache = addComponent<dbcache>("db_cache", config.db_cache, log_path, seed + lbsConfig::MAX_SERVERS + 2);
+        }
 
-        // model name, server id, mean processing time, log path
-        auto srv1 = addComponent<server>("server1", 1, 0.5, log_path);  
-        auto srv2 = addComponent<server>("server2", 2, 0.5, log_path);  
-        auto srv3 = addComponent<server>("server3", 3, 0.5, log_path); 
-        
-        // model name, db processing time, log path
-        auto db = addComponent<dbserver>("db_server", 1, log_path);  
+        // model name, link parameters, log path, rng seeds (after the cache seed, one per link)
+        for (int i = 0; config.dispatch_link.enabled() && i < config.servers; i++) {
+            dispatch_links.push_back(addComponent<wanlink>("dispatch_link" + std::to_string(i + 1), config.dispatch_link, log_path, seed + lbsConfig::MAX_SERVERS + 3 + i));
+        }
+        for (int i = 0; config.db_link.enabled() && i < config.servers; i++) {
+            db_links.push_back(addComponent<wanlink>("db_link" + std::to_string(i + 1), config.db_link, log_path, seed + 2 * lbsConfig::MAX_SERVERS + 3 + i));
+        }
+
+        std::array<Port<job>, lbsConfig::MAX_SERVERS> bal_out = {bal->balancer_out1, bal->balancer_out2, bal->balancer_out3};
+        std::array<Port<job>, lbsConfig::MAX_SERVERS> bal_done = {bal->balancer_in_done1, bal->balancer_in_done2, bal->balancer_in_done3};
+        std::array<Port<job>, lbsConfig::MAX_SERVERS> db_out = {db->dbserver_out1, db->dbserver_out2, db->dbserver_out3};
 
         // external input couplings
         addCoupling(in, bal->balancer_in);
-        
+
         // external Output Couplings
-        addCoupling(srv1->server_out1, out);
-        addCoupling(srv2->server_out1, out);
-        addCoupling(srv3->server_out1, out);
-        
+        for (const auto& s : srv) {
+            addCoupling(s->server_out1, out);
+        }
+
         // internal Couplings
-        addCoupling(bal->balancer_out1, srv1->server_in);
-        addCoupling(bal->balancer_out2, srv2->server_in);
-        addCoupling(bal->balancer_out3, srv3->server_in);
-
-        addCoupling(srv1->server_out2, db->dbserver_in);
-        addCoupling(srv2->server_out2, db->dbserver_in);
-        addCoupling(srv3->server_out2, db->dbserver_in);
-        
-        addCoupling(db->dbserver_out1, srv1->server_in_db);
-        addCoupling(db->dbserver_out2, srv2->server_in_db);
-        addCoupling(db->dbserver_out3, srv3->server_in_db);
+        // the jobs (and the db queries below) cross their link when there is one; the acknowledgments do not
+        for (std::size_t i = 0; i < srv.size(); i++) {
+            if (dispatch_links.empty()) {
+                addCoupling(bal_out[i], srv[i]->server_in);
+            } else {
+                addCoupling(bal_out[i], dispatch_links[i]->wanlink_in);
+                addCoupling(dispatch_links[i]->wanlink_out, srv[i]->server_in);
+            }
+        }
+
+        std::vector<Port<job>> db_query;  // ports the servers' queries leave the pool from
+        for (std::size_t i = 0; i < srv.size(); i++) {
+            if (db_links.empty()) {
+                db_query.push_back(srv[i]->server_out2);
+            } else {
+                addCoupling(srv[i]->server_out2, db_links[i]->wanlink_in);
+                db_query.push_back(db_links[i]->wanlink_out);
+            }
+        }
+
+        // the db queries go through the cache when there is one: only its misses reach the db server
+        if (cache) {
+            std::array<Port<job>, lbsConfig::MAX_SERVERS> cache_out = {cache->dbcache_out1, cache->dbcache_out2, cache->dbcache_out3};
+            for (std::size_t i = 0; i < srv.size(); i++) {
+                addCoupling(db_query[i], cache->dbcache_in);
+                addCoupling(cache_out[i], srv[i]->server_in_db);
+            }
+            addCoupling(cache->dbcache_out_db, db->dbserver_in);
+        } else {
+            for (const auto& query : db_query) {
+                addCoupling(query, db->dbserver_in);
+            }
+        }
+
+        for (std::size_t i = 0; i < srv.size(); i++) {
+            addCoupling(db_out[i], srv[i]->server_in_db);
+        }
+
+        for (std::size_t i = 0; i < srv.size(); i++) {
+            addCoupling(srv[i]->server_out1, bal_done[i]);
+        }
+
+        if (inj) {
+            std::array<Port<int>, lbsConfig::MAX_SERVERS> inj_out = {inj->faultinjector_out1, inj->faultinjector_out2, inj->faultinjector_out3};
+            std::array<Port<int>, lbsConfig::MAX_SERVERS> bal_health = {bal->balancer_in_health1, bal->balancer_in_health2, bal->balancer_in_health3};
+            for (std::size_t i = 0; i < srv.size(); i++) {
+                addCoupling(inj_out[i], srv[i]->server_in_ctrl);
+                addCoupling(inj_out[i], bal_health[i]);
+            }
+        }
+
+        if (scaler) {
+            std::array<Port<job>, lbsConfig::MAX_SERVERS> scaler_dispatched = {scaler->autoscaler_in_dispatched1, scaler->autoscaler_in_dispatched2, scaler->autoscaler_in_dispatched3};
+            std::array<Port<job>, lbsConfig::MAX_SERVERS> scaler_done = {scaler->autoscaler_in_done1, scaler->autoscaler_in_done2, scaler->autoscaler_in_done3};
+            for (std::size_t i = 0; i < srv.size(); i++) {
+                addCoupling(bal_out[i], scaler_dispatched[i]);
+                addCoupling(srv[i]->server_out1, scaler_done[i]);
+            }
+            addCoupling(scaler->autoscaler_out, bal->balancer_in_active);
+        }
+
+        if (stealer) {
+            std::array<Port<job>, lbsConfig::MAX_SERVERS> stealer_dispatched = {stealer->workstealer_in_dispatched1, stealer->workstealer_in_dispatched2, stealer->workstealer_in_dispatched3};
+            std::array<Port<job>, lbsConfig::MAX_SERVERS> stealer_done = {stealer->workstealer_in_done1, stealer->workstealer_in_done2, stealer->workstealer_in_done3};
+            std::array<Port<int>, lbsConfig::MAX_SERVERS> stealer_health = {stealer->workstealer_in_health1, stealer->workstealer_in_health2, stealer->workstealer_in_health3};
+            std::array<Port<int>, lbsConfig::MAX_SERVERS> stealer_out = {stealer->workstealer_out1, stealer->workstealer_out2, stealer->workstealer_out3};
+            std::array<Port<int>, lbsConfig::MAX_SERVERS> stealer_refused = {stealer->workstealer_in_refused1, stealer->workstealer_in_refused2, stealer->workstealer_in_refused3};
+            for (std::size_t i = 0; i < srv.size(); i++) {
+                // a job on the dispatch wire cannot be stolen yet: it counts once delivered
+                addCoupling(dispatch_links.empty() ? bal_out[i] : dispatch_links[i]->wanlink_out, stealer_dispatched[i]);
+                addCoupling(srv[i]->server_out1, stealer_done[i]);
+                addCoupling(stealer_out[i], srv[i]->server_in_steal);
+                addCoupling(srv[i]->server_out_refused, stealer_refused[i]);
+                for (std::size_t j = 0; j < srv.size(); j++) {
+                    if (j != i) {
+                        addCoupling(srv[i]->server_out_stolen, srv[j]->server_in_stolen);
+                    }
+                }
+            }
+            if (inj) {
+                std::array<Port<int>, lbsConfig::MAX_SERVERS> inj_out = {inj->faultinjector_out1, inj->faultinjector_out2, inj->faultinjector_out3};
+                for (std::size_t i = 0; i < srv.size(); i++) {
+                    addCoupling(inj_out[i], stealer_health[i]);
+                }
+            }
+            if (scaler) {
+                addCoupling(scaler->autoscaler_out, stealer->workstealer_in_active);
+            }
+            addCoupling(stealer->workstealer_out_moves, bal->balancer_in_moves);
+        }
+
+        // a cancelled copy leaves its server like a finished job, for every model counting the jobs in the servers;
+        // the cancel also reaches the dispatch links, where a copy may still be in transit (never delivered, so
+        // the work stealer does not hear of it)
+        if (config.hedging.enabled) {
+            for (std::size_t i = 0; i < srv.size(); i++) {
+                std::vector<Port<job>> cancelled = {srv[i]->server_out_cancelled};
+                addCoupling(bal->balancer_out_cancel, srv[i]->server_in_cancel);
+                if (!dispatch_links.empty()) {
+                    addCoupling(bal->balancer_out_cancel, dispatch_links[i]->wanlink_in_cancel);
+                    cancelled.push_back(dispatch_links[i]->wanlink_out_cancelled);
+                }
+                for (const auto& copy : cancelled) {
+                    addCoupling(copy, bal_done[i]);
+                    if (scaler) {
+                        std::array<Port<job>, lbsConfig::MAX_SERVERS> scaler_done = {scaler->autoscaler_in_done1, scaler->autoscaler_in_done2, scaler->autoscaler_in_done3};
+                        addCoupling(copy, scaler_done[i]);
+                    }
+                }
+                if (stealer) {
+                    std::array<Port<job>, lbsConfig::MAX_SERVERS> stealer_done = {stealer->workstealer_in_done1, stealer->workstealer_in_done2, stealer->workstealer_in_done3};
+                    addCoupling(srv[i]->server_out_cancelled, stealer_done[i]);
+                }
+            }
+        }
+    }
+
+    // adds the balancer, the servers (named prefix + id) and the db server to a metrics sample
+    void sample(metricsSample& m, const std::string& prefix = "") const {
+        bal->sample(m);
+        for (std::size_t i = 0; i < srv.size(); i++) {
+            srv[i]->sample(m, prefix + std::to_string(i + 1));
+        }
+        db->sample(m);
+    }
+
+    // summary of every component at simulation time t
+    void report(std::ostream& os, double t) const {
+        bal->report(os);
+        std::array<latencyStats, job::MAX_CLASSES> latency;
+        timeline completions;
+        int lost = 0;
+        for (const auto& s : srv) {
+            s->report(os, t);
+            s->collect(latency, completions, lost);
+        }
+        db->report(os, t);
+        if (cache) {
+            cache->report(os, t);
+        }
+        for (const auto& l : dispatch_links) {
+            l->report(os, t);
+        }
+        for (const auto& l : db_links) {
+            l->report(os, t);
+        }
+        if (scaler) {
+            scaler->report(os, t);
+        }
+        if (stealer) {
+            stealer->report(os);
+        }
+        reportPool(os, latency, completions, lost, inj != nullptr);
+    }
+
+    // checkpoint: writes the state of every component as seen at simulation time t
+    void save(std::ostream& os, double t) const {
+        snapshot::write(os, static_cast<int>(srv.size()));
+        bal->save(os, t);
+        for (const auto& s : srv) {
+            s->save(os, t);
+        }
+        db->save(os, t);
+        snapshot::write(os, inj != nullptr);
+        if (inj) {
+            inj->save(os, t);
+        }
+        snapshot::write(os, scaler != nullptr);
+        if (scaler) {
+            scaler->save(os, t);
+        }
+        snapshot::write(os, stealer != nullptr);
+        if (stealer) {
+            stealer->save(os, t);
+        }
+        snapshot::write(os, cache != nullptr);
+        if (cache) {
+            cache->save(os, t);
+        }
+        snapshot::write(os, static_cast<int>(dispatch_links.size()));
+        for (const auto& l : dispatch_links) {
+            l->save(os, t);
+        }
+        snapshot::write(os, static_cast<int>(db_links.size()));
+        for (const auto& l : db_links) {
+            l->save(os, t);
+        }
+    }
+
+    // checkpoint: reads the states written by save() at simulation time t
+    bool restore(std::istream& is, double t) {
+        int servers = 0;
+        if (!snapshot::read(is, servers) || servers != static_cast<int>(srv.size())) {
+            std::cerr << "Error: snapshot has " << servers << " servers, the model has " << srv.size() << std::endl;
+            return false;
+        }
+        bool ok = bal->restore(is, t);
+        for (const auto& s : srv) {
+            ok = ok && s->restore(is, t);
+        }
+        bool faults = false;
+        if (!ok || !db->restore(is, t) || !snapshot::read(is, faults)) {
+            return false;
+        }
+        if (faults != (inj != nullptr)) {
+            std::cerr << "Error: snapshot " << (faults ? "has" : "has no") << " fault injector, the model " << (inj ? "has one" : "has none") << std::endl;
+            return false;
+        }
+        bool scaling = false;
+        if ((inj && !inj->restore(is, t)) || !snapshot::read(is, scaling)) {
+            return false;
+        }
+        if (scaling != (scaler != nullptr)) {
+            std::cerr << "Error: snapshot " << (scaling ? "has" : "has no") << " autoscaler, the model " << (scaler ? "has one" : "has none") << std::endl;
+            return false;
+        }
+        bool stealing = false;
+        if ((scaler && !scaler->restore(is, t)) || !snapshot::read(is, stealing)) {
+            return false;
+        }
+        if (stealing != (stealer != nullptr)) {
+            std::cerr << "Error: snapshot " << (stealing ? "has" : "has no") << " work stealer, the model " << (stealer ? "has one" : "has none") << std::endl;
+            return false;
+        }
+        bool caching = false;
+        if ((stealer && !stealer->restore(is, t)) || !snapshot::read(is, caching)) {
+            return false;
+        }
+        if (caching != (cache != nullptr)) {
+            std::cerr << "Error: snapshot " << (caching ? "has" : "has no") << " db cache, the model " << (cache ? "has one" : "has none") << std::endl;
+            return false;
+        }
+        int links = 0;
+        if ((cache && !cache->restore(is, t)) || !snapshot::read(is, links)) {
+            return false;
+        }
+        if (links != static_cast<int>(dispatch_links.size())) {
+            std::cerr << "Error: snapshot has " << links << " dispatch links, the model has " << dispatch_links.size() << std::endl;
+            return false;
+        }
+        for (const auto& l : dispatch_links) {
+            if (!l->restore(is, t)) {
+                return false;
+            }
+        }
+        if (!snapshot::read(is, links)) {
+            return false;
+        }
+        if (links != static_cast<int>(db_links.size())) {
+            std::cerr << "Error: snapshot has " << links << " db links, the model has " << db_links.size() << std::endl;
+            return false;
+        }
+        for (const auto& l : db_links) {
+            if (!l->restore(is, t)) {
+                return false;
+            }
+        }
+        return true;
     }
 };
 
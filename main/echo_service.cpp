@@ -0,0 +1,85 @@
+
+/*
+Local stand-in for the work of the servers in load tests. Listens on 127.0.0.1:<port> and
+answers every line it receives with the same line, after a delay drawn per request
+(constant or exponential with the given mean, in seconds; 0 answers at once). Each
+connection is served by its own thread, so the servers of a pool are served in parallel:
+
+	./bin/echo_service 9000 0.05 exponential
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <iostream>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "utils/distribution.hpp"
+
+// answers the requests of one connection until it is closed
+void serve(int fd, double delay, distributionType type, unsigned int seed) {
+	std::mt19937 rng(seed);
+	std::exponential_distribution<double> dist(delay > 0 ? 1.0 / delay : 1.0);
+	std::string pending;
+	char buffer[256];
+	while (true) {
+		auto n = ::recv(fd, buffer, sizeof(buffer), 0);
+		if (n <= 0) {
+			break;
+		}
+		pending.append(buffer, static_cast<std::size_t>(n));
+		std::size_t end;
+		while ((end = pending.find('\n')) != std::string::npos) {
+			std::string line = pending.substr(0, end + 1);
+			pending.erase(0, end + 1);
+			double wait = (type == distributionType::exponential && delay > 0) ? dist(rng) : delay;
+			std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+			if (::send(fd, line.data(), line.size(), 0) != static_cast<ssize_t>(line.size())) {
+				::close(fd);
+				return;
+			}
+		}
+	}
+	::close(fd);
+}
+
+int main(int argc, char* argv[]) {
+
+	if (argc < 2 || argc > 4) {
+		std::cerr << "Usage: " << argv[0] << " <port> [delay] [constant|exponential]" << std::endl;
+		return 2;
+	}
+	int port = std::stoi(argv[1]);
+	double delay = argc > 2 ? std::stod(argv[2]) : 0.0;
+	distributionType type = distributionType::constant;
+	if (argc > 3 && !parseDistribution(argv[3], type)) {
+		std::cerr << "Error: unknown distribution " << argv[3] << std::endl;
+		return 2;
+	}
+
+	int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+	int reuse = 1;
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(static_cast<std::uint16_t>(port));
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (listener < 0 || ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0
+		|| ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listener, 16) != 0) {
+		std::cerr << "Error: could not listen on 127.0.0.1:" << port << std::endl;
+		return 1;
+	}
+	std::cerr << "echo service on 127.0.0.1:" << port << ", " << distributionName(type) << " delay " << delay << " s" << std::endl;
+
+	unsigned int connections = 0;
+	while (true) {
+		int fd = ::accept(listener, nullptr, nullptr);
+		if (fd < 0) {
+			continue;
+		}
+		std::thread(serve, fd, delay, type, std::random_device{}() + connections++).detach();
+	}
+}
@@ -0,0 +1,50 @@
+
+/*
+Predicts the utilisation, throughput and mean sojourn time of every station of a scenario
+with closed-form queueing formulas, without simulating. With --compare the scenario is
+also run on the flat engine and each prediction is printed next to its measure:
+
+	./bin/predict_scenario main/scenarios/default.ini
+	./bin/predict_scenario --compare main/scenarios/default.ini
+*/
+
+#include <string>
+#include <iostream>
+#include "../Top_model/flat_top.hpp"
+#include "../Top_model/scenario.hpp"
+#include "../Top_model/analysis.hpp"
+
+int main(int argc, char* argv[]) {
+
+	bool compare = (argc == 3 && std::string(argv[1]) == "--compare");
+	if (argc != 2 && !compare) {
+		std::cerr << "Usage: " << argv[0] << " [--compare] <scenario.ini>" << std::endl;
+		return 2;
+	}
+
+	scenarioConfig scenario;
+	if (!loadScenario(argv[argc - 1], scenario)) {
+		return 2;
+	}
+	if (scenario.top.regions.enabled()) {
+		std::cerr << "Error: " << argv[argc - 1] << ": the queueing model covers a single pool, not regions" << std::endl;
+		return 2;
+	}
+
+	queueingEstimate estimate = predict(scenario.top);
+	if (!compare) {
+		printEstimate(std::cout, estimate);
+		return 0;
+	}
+
+	// the event trace of the run is not printed, only the comparison
+	Flat_top<> flat(scenario.top, scenario.log_path, scenario.seed);
+	std::cout.setstate(std::ios::failbit);
+	flat.start();
+	flat.simulate(scenario.horizon);
+	std::cout.clear();
+
+	std::cout << "measured over " << flat.getTime() << " s:" << std::endl;
+	printEstimate(std::cout, estimate, measure(flat, scenario.top));
+	return 0;
+}
@@ -0,0 +1,119 @@
+
+/*
+Profiles the flat Top model: the time of every transition function of each component
+(CPU cycles on the ESP32, CLOCK_MONOTONIC on hosts), the heap high-water mark and the
+job rate the model sustains on this CPU. On a host the configuration is read from a
+scenario file; on the device it is the default one, run for PROFILE_HORIZON seconds.
+With --quiet (PROFILE_QUIET on the device) the models' std::cout lines are muted, so the
+difference between the two runs is the cost of the console log:
+
+	./bin/profile_model main/scenarios/default.ini > /dev/null
+	./bin/profile_model --quiet main/scenarios/default.ini
+*/
+
+#include <string>
+#include <iostream>
+#include "../Top_model/flat_top.hpp"
+#include "../Top_model/scenario.hpp"
+#include "utils/profiler.hpp"
+
+#ifndef PROFILE_HORIZON
+	#define PROFILE_HORIZON 600.1
+#endif
+
+using profiledTop = Flat_top<profiled<generator>, profiled<balancer>, profiled<server>, profiled<dbserver>, profiled<faultinjector>,
+                             profiled<autoscaler>, profiled<workstealer>, profiled<dbcache>, profiled<wanlink>>;
+
+// runs the model and prints the profile of each component that had transitions on `os`
+void profile(const scenarioConfig& scenario, bool quiet, std::ostream& os) {
+
+	if (quiet) {
+		std::cout.setstate(std::ios::failbit);
+	}
+
+	// the same run without the probes gives the rate of the simulator itself
+	double plain_elapsed = 0.0;
+	{
+		Flat_top<> plain(scenario.top, "/dev/null", scenario.seed);
+		auto start = cycleCounter::now();
+		plain.start();
+		plain.simulate(scenario.horizon);
+		plain_elapsed = cycleCounter::microsecondsSince(start);
+	}
+
+	std::size_t baseline = heapRise();
+	profiledTop flat(scenario.top, "/dev/null", scenario.seed);
+	auto start = cycleCounter::now();
+	flat.start();
+	flat.simulate(scenario.horizon);
+	double elapsed = cycleCounter::microsecondsSince(start);
+	std::cout.clear();
+
+	unsigned long jobs = static_cast<unsigned long>(flat.sample().generated);
+	auto events = static_cast<double>(flat.getEvents());
+	os << "profile of " << flat.getTime() << " s" << (quiet ? " (console log muted)" : "") << ": " << jobs << " jobs, " << flat.getEvents()
+	   << " transitions in " << plain_elapsed / 1000.0 << " ms (" << elapsed / 1000.0 << " ms profiled)" << std::endl;
+	os << "simulator: " << events / plain_elapsed * 1e6 << " transitions/s, " << jobs / plain_elapsed * 1e6 << " jobs/s" << std::endl;
+	os << "heap high-water: " << heapHighWater() << " bytes (" << baseline << " before the profiled model)" << std::endl;
+
+	printProfile(os, "generator", flat.gen.getProfile(), jobs);
+	printProfile(os, "balancer", flat.bal.getProfile(), jobs);
+	for (int i = 0; i < scenario.top.lbs.servers; i++) {
+		printProfile(os, "server " + std::to_string(i + 1), flat.srv[i].getProfile(), jobs);
+	}
+	printProfile(os, "dbserver", flat.db.getProfile(), jobs);
+	auto optional = [&os, jobs](const std::string& name, const transitionProfile& p) {
+		if (p.transitions() > 0) {
+			printProfile(os, name, p, jobs);
+		}
+	};
+	optional("faultinjector", flat.inj.getProfile());
+	optional("autoscaler", flat.scaler.getProfile());
+	optional("workstealer", flat.stealer.getProfile());
+	optional("dbcache", flat.cache.getProfile());
+	for (int i = 0; i < scenario.top.lbs.servers; i++) {
+		optional("dispatch link " + std::to_string(i + 1), flat.dispatch_link[i].getProfile());
+		optional("db link " + std::to_string(i + 1), flat.db_link[i].getProfile());
+	}
+}
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main(int argc, char* argv[])
+	#endif
+	{
+		scenarioConfig scenario;
+
+		#ifdef ESP_PLATFORM
+			scenario.horizon = PROFILE_HORIZON;
+			scenario.seed = 1234;
+			#ifdef PROFILE_QUIET
+				profile(scenario, true, std::cerr);
+			#else
+				profile(scenario, false, std::cerr);
+			#endif
+		#else
+			bool quiet = (argc > 1 && std::string(argv[1]) == "--quiet");
+			if (argc > 2 + quiet) {
+				std::cerr << "Usage: " << argv[0] << " [--quiet] [scenario.ini]" << std::endl;
+				return 2;
+			}
+			if (argc == 2 + quiet) {
+				if (!loadScenario(argv[1 + quiet], scenario)) {
+					return 2;
+				}
+			} else {
+				scenario.horizon = PROFILE_HORIZON;
+				scenario.seed = 1234;
+			}
+			if (scenario.top.regions.enabled()) {
+				std::cerr << "Error: the flat model has a single pool, regions cannot be profiled" << std::endl;
+				return 2;
+			}
+			profile(scenario, quiet, std::cerr);
+			return 0;
+		#endif
+	}
+}
@@ -0,0 +1,159 @@
+
+/*
+Runs the TOP model with the topology, parameters, horizon and outputs read from a scenario file,
+so experiments do not need a rebuild. A summary of the run is printed on the standard error:
+
+	./bin/run_scenario main/scenarios/default.ini
+*/
+
+#include <limits>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sys/resource.h>
+#include "../Top_model/top.hpp"
+#include "../Top_model/flat_top.hpp"
+#include "../Top_model/scenario.hpp"
+#include "utils/exporter.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#include <cadmium/simulation/rt_clock/chrono.hpp>
+#endif
+
+#ifndef NO_LOGGING
+	#include "cadmium/simulation/logger/stdout.hpp"
+	#include "cadmium/simulation/logger/csv.hpp"
+#endif
+
+using namespace cadmium;
+
+// peak resident set size of the process, in megabytes
+double peakMemory() {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	#ifdef __APPLE__
+		return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);  // bytes
+	#else
+		return static_cast<double>(usage.ru_maxrss) / 1024.0;  // kilobytes
+	#endif
+}
+
+// simulates from start to the horizon; with an exporter, in steps of the metrics period,
+// publishing a sample after each step while a client reads them
+template<typename SIMULATE, typename SAMPLE>
+void simulateTo(const scenarioConfig& scenario, double start, metricsExporter* exporter, SIMULATE simulate, SAMPLE sample) {
+	if (exporter == nullptr) {
+		simulate(scenario.horizon - start);
+		return;
+	}
+	double now = start;
+	for (int k = 1; now < scenario.horizon; k++) {
+		double dt = std::min(start + k * scenario.metrics.period, scenario.horizon) - now;
+		simulate(dt);
+		now += dt;
+		if (exporter->wanted()) {
+			exporter->publish(sample(now));
+		}
+	}
+}
+
+// runs the scenario on the flattened model; returns the process exit code
+int runFlat(const scenarioConfig& scenario, metricsExporter* exporter) {
+
+	Flat_top<> flat(scenario.top, scenario.log_path, scenario.seed);
+
+	if (scenario.restore_path.empty()) {
+		flat.start();
+	} else {
+		std::ifstream file(scenario.restore_path, std::ios::binary);
+		if (!flat.restore(file)) {
+			return 1;
+		}
+	}
+	simulateTo(scenario, flat.getTime(), exporter, [&flat](double dt) { flat.simulate(dt); }, [&flat](double) { return flat.sample(); });
+	flat.report(std::cerr);
+
+	if (!scenario.save_path.empty()) {
+		std::ofstream file(scenario.save_path, std::ios::binary);
+		flat.save(file);
+	}
+	return 0;
+}
+
+// runs the scenario on Top_coupled; returns the process exit code
+int runGeneric(const scenarioConfig& scenario, metricsExporter* exporter) {
+
+	auto model = std::make_shared<Top_coupled>("Top_coupled", scenario.top, scenario.log_path, scenario.seed);
+
+	double start_time = 0.0;
+	if (!scenario.restore_path.empty()) {
+		std::ifstream file(scenario.restore_path, std::ios::binary);
+		if (!model->restore(file, start_time)) {
+			return 1;
+		}
+	}
+
+	#ifdef SIM_TIME
+		auto rootCoordinator = cadmium::RootCoordinator(model, start_time);
+	#else
+		cadmium::ChronoClock clock;
+		auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+	#endif
+
+	#ifndef NO_LOGGING
+		if (scenario.stdout_log) {
+			rootCoordinator.setLogger<STDOUTLogger>(";");
+		}
+		if (!scenario.csv_path.empty()) {
+			rootCoordinator.setLogger<CSVLogger>(scenario.csv_path, ";");
+		}
+	#endif
+
+	#ifndef SIM_TIME
+		auto wall_start = std::chrono::steady_clock::now();
+	#endif
+	rootCoordinator.start();
+	simulateTo(scenario, start_time, exporter, [&rootCoordinator](double dt) { rootCoordinator.simulate(dt); }, [&model](double t) { return model->sample(t); });
+	rootCoordinator.stop();
+	model->report(std::cerr, scenario.horizon);
+
+	#ifndef SIM_TIME
+		// in real time the model time follows the wall clock; the lag is the time the models and the coordinator fell behind
+		double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+		std::cerr << "wall-clock time: " << wall << " s for " << scenario.horizon - start_time << " s of model time, lag " << wall - (scenario.horizon - start_time) << " s" << std::endl;
+	#endif
+
+	if (!scenario.save_path.empty()) {
+		std::ofstream file(scenario.save_path, std::ios::binary);
+		model->save(file, scenario.horizon);
+	}
+	return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+	if (argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " <scenario.ini>" << std::endl;
+		return 2;
+	}
+
+	scenarioConfig scenario;
+	if (!loadScenario(argv[1], scenario)) {
+		return 2;
+	}
+
+	std::unique_ptr<metricsExporter> exporter;
+	if (scenario.metrics.enabled()) {
+		exporter = std::make_unique<metricsExporter>(scenario.metrics);
+	}
+	int code = scenario.flat ? runFlat(scenario, exporter.get()) : runGeneric(scenario, exporter.get());
+	if (scenario.bounded) {
+		std::cerr << "peak memory: " << peakMemory() << " MB" << std::endl;
+	}
+	return code;
+}
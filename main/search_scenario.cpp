@@ -0,0 +1,125 @@
+
+/*
+Searches the cheapest balancer and pool configuration of a scenario whose server latency
+p99 meets a target, then prints the sensitivity of the p99 to each parameter around it.
+Candidates run in parallel, with common random numbers across candidates:
+
+	./bin/search_scenario main/scenarios/capacity_search.ini
+*/
+
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include "../Top_model/top.hpp"
+#include "../Top_model/flat_top.hpp"
+#include "../Top_model/scenario.hpp"
+#include "../Top_model/search.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#include <cadmium/simulation/rt_clock/chrono.hpp>
+#endif
+
+// server latency p99 and balancer backlog of one replication of a candidate; the event logs are discarded
+searchRun replicate(const scenarioConfig& scenario, const searchCandidate& candidate, int replication) {
+	topConfig config = configure(scenario.top, candidate);
+	unsigned int seed = scenario.seed + static_cast<unsigned int>(replication) * searchConfig::SEED_STRIDE;
+	if (scenario.flat) {
+		Flat_top<> flat(config, "/dev/null", seed);
+		flat.start();
+		flat.simulate(scenario.horizon);
+		metricsSample sample = flat.sample();
+		return searchRun{sample.latency.quantile(0.99), sample.balancer_queue};
+	}
+	auto model = std::make_shared<Top_coupled>("Top_coupled", config, "/dev/null", seed);
+	#ifdef SIM_TIME
+		auto rootCoordinator = cadmium::RootCoordinator(model);
+	#else
+		cadmium::ChronoClock clock;
+		auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+	#endif
+	rootCoordinator.start();
+	rootCoordinator.simulate(scenario.horizon);
+	rootCoordinator.stop();
+	metricsSample sample = model->sample(scenario.horizon);
+	return searchRun{sample.latency.quantile(0.99), sample.balancer_queue};
+}
+
+int main(int argc, char* argv[]) {
+
+	if (argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " <search.ini>" << std::endl;
+		return 2;
+	}
+
+	searchConfig search;
+	scenarioConfig scenario;
+	if (!loadSearch(argv[1], search, scenario)) {
+		return 2;
+	}
+	unsigned int threads = search.threads > 0 ? static_cast<unsigned int>(search.threads) : std::max(1u, std::thread::hardware_concurrency());
+
+	// runs a batch of (candidate, replication) pairs on the worker threads
+	auto run = [&scenario, threads](const std::vector<searchCandidate>& candidates, const std::vector<std::pair<std::size_t, int>>& tasks) {
+		std::vector<searchRun> runs(tasks.size());
+		std::atomic<std::size_t> next{0};
+		auto work = [&]() {
+			for (std::size_t t = next++; t < tasks.size(); t = next++) {
+				runs[t] = replicate(scenario, candidates[tasks[t].first], tasks[t].second);
+			}
+		};
+		std::vector<std::thread> pool;
+		for (unsigned int k = 1; k < std::min<std::size_t>(threads, tasks.size()); k++) {
+			pool.emplace_back(work);
+		}
+		work();
+		for (auto& thread : pool) {
+			thread.join();
+		}
+		return runs;
+	};
+
+	std::vector<searchCandidate> candidates = enumerateCandidates(search);
+	std::cout << "searching " << candidates.size() << " configurations of " << search.scenario_path << " for p99 <= " << search.target
+	          << " s over " << scenario.horizon << " s (" << threads << (threads == 1 ? " thread" : " threads") << ")" << std::endl;
+
+	// the models print their events on std::cout; only the search is printed
+	std::ostringstream progress;
+	std::cout.setstate(std::ios::failbit);
+	int best = searchCheapest(search, candidates, run, progress);
+	std::cout.clear();
+	std::cout << progress.str();
+
+	if (best < 0) {
+		std::cout << "no configuration meets the target" << std::endl;
+		return 1;
+	}
+	const searchCandidate& selected = candidates[best];
+	std::cout << std::endl << "selected: ";
+	printCandidate(std::cout, selected);
+	std::cout << std::endl << "  ";
+	printResult(std::cout, selected, search.target);
+	std::cout << std::endl << std::endl << "[balancer]" << std::endl
+	          << "policy = " << policyName(selected.policy) << std::endl
+	          << "dispatch_time = " << selected.dispatch_time << std::endl
+	          << "workers = " << selected.workers << std::endl
+	          << "[servers]" << std::endl
+	          << "count = " << selected.servers << std::endl
+	          << "[dbserver]" << std::endl
+	          << "batch_size = " << selected.db_batch << std::endl;
+
+	if (search.sensitivity) {
+		std::ostringstream sensitivity;
+		std::cout.setstate(std::ios::failbit);
+		printSensitivity(search, selected, run, sensitivity);
+		std::cout.clear();
+		std::cout << std::endl << sensitivity.str();
+	}
+	return 0;
+}
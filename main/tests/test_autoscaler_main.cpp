@@ -0,0 +1,96 @@
+/*
+Test main file for the autoscaler atomic model: jobs keep arriving at server 1 and never finish,
+so the autoscaler provisions server 2 once a full interval is busy (t = 2) and activates it 2 seconds later
+*/
+
+#include <limits>
+#include "cadmium/modeling/devs/coupled.hpp"
+#include "cadmium/lib/iestream.hpp"
+#include "../atomic_models/autoscaler.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#ifdef ESP_PLATFORM
+		#include <cadmium/simulation/rt_clock/ESPclock.hpp>
+	#else
+		#include <cadmium/simulation/rt_clock/chrono.hpp>
+	#endif
+#endif
+
+#ifndef NO_LOGGING
+	#include "cadmium/simulation/logger/stdout.hpp"
+	#include "cadmium/simulation/logger/csv.hpp"
+#endif
+
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
+using namespace cadmium;
+
+struct test_autoscaler_coupled : public Coupled {
+    test_autoscaler_coupled(const std::string& id) : Coupled(id) {
+
+        // create IEStream component to read the jobs dispatched to server 1 from a CSV file
+        auto job_stream = addComponent<lib::IEStream<job>>("job_stream", TEST_INPUTS_DIR "/Input_In_Autoscaler_Testing.csv");
+
+		// one decision per second, 2 seconds of provisioning, no cooldown
+        autoscalerConfig scaling;
+        scaling.enabled = true;
+        scaling.interval = 1;
+        scaling.provision_delay = 2;
+        scaling.cooldown = 0;
+
+		// model name, autoscaling parameters, number of servers, log path
+        auto scaler = addComponent<autoscaler>("autoscaler", scaling, 2, "simulation_results/autoscaler_log.txt");
+
+        // connect the jobs to the autoscaler
+        addCoupling(job_stream->out, scaler->autoscaler_in_dispatched1);
+    }
+};
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main()
+	#endif
+	{
+	
+		auto model = std::make_shared<test_autoscaler_coupled>("test_autoscaler");
+		
+		#ifdef SIM_TIME
+			auto rootCoordinator = cadmium::RootCoordinator(model);
+		#else
+			#ifdef ESP_PLATFORM
+				cadmium::ESPclock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+			#else
+				cadmium::ChronoClock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+			#endif
+		#endif
+
+		#ifndef NO_LOGGING
+			rootCoordinator.setLogger<STDOUTLogger>(";");
+			rootCoordinator.setLogger<CSVLogger>("simulation_results/autoscaler_output.csv", ";");
+		#endif
+
+		rootCoordinator.start();
+		
+		#ifdef ESP_PLATFORM
+			rootCoordinator.simulate(std::numeric_limits<double>::infinity());
+		#else
+			rootCoordinator.simulate(10.0);
+		#endif
+		
+		rootCoordinator.stop();	
+
+		#ifndef ESP_PLATFORM
+			return 0;
+		#endif
+	}
+}
@@ -24,13 +24,18 @@ Test main file for the balancer atomic model
 	#include "cadmium/simulation/logger/csv.hpp"
 #endif
 
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
 using namespace cadmium;
 
 struct test_balancer_coupled : public Coupled {
     test_balancer_coupled(const std::string& id) : Coupled(id) {
 
         // create IEStream components to read from CSV files
-        auto job_stream = addComponent<lib::IEStream<int>>("balancer_input_test", "<ABSOLUTE_PATH>/main/test_inputs/Input_In_Balancer_Testing.csv");
+        auto job_stream = addComponent<lib::IEStream<job>>("balancer_input_test", TEST_INPUTS_DIR "/Input_In_Balancer_Testing.csv");
         auto bal = addComponent<balancer>("balancer", 1.0);
 
         // connect IEStream directly to balancer
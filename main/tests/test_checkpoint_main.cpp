@@ -0,0 +1,116 @@
+
+/*
+Test main file for checkpoint and restore of the TOP coupled model.
+Warms the model up, writes a snapshot, then resumes two branches from it
+(one with Top_coupled, one with Flat_top) and checks that they end in the same state.
+*/
+
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include "../Top_model/top.hpp"
+#include "../Top_model/flat_top.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#ifdef ESP_PLATFORM
+		#include <cadmium/simulation/rt_clock/ESPclock.hpp>
+	#else
+		#include <cadmium/simulation/rt_clock/chrono.hpp>
+	#endif
+#endif
+
+using namespace cadmium;
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main()
+	#endif
+	{
+		const std::string snapshot_path = "simulation_results/top_checkpoint.bin";
+		const std::string log_path = "simulation_results/checkpoint_log.txt";
+		const double warmup = 1800.0;
+		const double horizon = 3600.1;
+
+		// warm-up run, paid once
+		{
+			auto model = std::make_shared<Top_coupled>("Top_coupled", log_path);
+			#ifdef SIM_TIME
+				auto rootCoordinator = cadmium::RootCoordinator(model);
+			#else
+				#ifdef ESP_PLATFORM
+					cadmium::ESPclock clock;
+					auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+				#else
+					cadmium::ChronoClock clock;
+					auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+				#endif
+			#endif
+			rootCoordinator.start();
+			rootCoordinator.simulate(warmup);
+			rootCoordinator.stop();
+
+			std::ofstream file(snapshot_path, std::ios::binary);
+			model->save(file, warmup);
+			std::cerr << "Snapshot written to " << snapshot_path << " at t=" << warmup << std::endl;
+		}
+
+		// branch 1: resume the generic model from the snapshot
+		std::ostringstream branch1;
+		{
+			auto model = std::make_shared<Top_coupled>("Top_coupled", log_path);
+			std::ifstream file(snapshot_path, std::ios::binary);
+			double t = 0.0;
+			if (!model->restore(file, t)) {
+				#ifndef ESP_PLATFORM
+					return 1;
+				#else
+					return;
+				#endif
+			}
+			#ifdef SIM_TIME
+				auto rootCoordinator = cadmium::RootCoordinator(model, t);
+			#else
+				#ifdef ESP_PLATFORM
+					cadmium::ESPclock clock;
+					auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+				#else
+					cadmium::ChronoClock clock;
+					auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+				#endif
+			#endif
+			rootCoordinator.start();
+			rootCoordinator.simulate(horizon - t);
+			rootCoordinator.stop();
+			model->save(branch1, horizon);
+		}
+
+		// branch 2: resume the flattened model from the same snapshot
+		std::ostringstream branch2;
+		{
+			Flat_top<> flat(log_path);
+			std::ifstream file(snapshot_path, std::ios::binary);
+			if (!flat.restore(file)) {
+				#ifndef ESP_PLATFORM
+					return 1;
+				#else
+					return;
+				#endif
+			}
+			flat.simulate(horizon - flat.getTime());
+			flat.save(branch2);
+		}
+
+		bool same = branch1.str() == branch2.str();
+		std::cerr << "Branches resumed from the snapshot end in " << (same ? "the same state" : "different states") << std::endl;
+
+		#ifndef ESP_PLATFORM
+			return same ? 0 : 1;
+		#endif
+	}
+}
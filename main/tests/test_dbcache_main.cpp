@@ -0,0 +1,97 @@
+/*
+Test main file for the db cache atomic model: every query reads the single key of a one-key cache,
+so job 1 (t = 1) misses and goes on to the DB, while jobs 2, 3 and 4 hit and are acknowledged to
+their servers (2, 3 and 1) 0.1 later
+*/
+
+#include <limits>
+#include "cadmium/modeling/devs/coupled.hpp"
+#include "cadmium/lib/iestream.hpp"
+#include "../atomic_models/dbcache.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#ifdef ESP_PLATFORM
+		#include <cadmium/simulation/rt_clock/ESPclock.hpp>
+	#else
+		#include <cadmium/simulation/rt_clock/chrono.hpp>
+	#endif
+#endif
+
+#ifndef NO_LOGGING
+	#include "cadmium/simulation/logger/stdout.hpp"
+	#include "cadmium/simulation/logger/csv.hpp"
+#endif
+
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
+using namespace cadmium;
+
+struct test_dbcache_coupled : public Coupled {
+    test_dbcache_coupled(const std::string& id) : Coupled(id) {
+
+        // create IEStream component to read the queries of the servers from a CSV file
+        auto job_stream = addComponent<lib::IEStream<job>>("job_stream", TEST_INPUTS_DIR "/Input_In_DBCache_Testing.csv");
+
+		// a single key, so only the first query misses
+        dbCacheConfig caching;
+        caching.enabled = true;
+        caching.capacity = 1;
+        caching.keys = 1;
+        caching.hit_time = 0.1;
+
+		// model name, cache parameters, log path, rng seed
+        auto cache = addComponent<dbcache>("db_cache", caching, "simulation_results/dbcache_log.txt", 1234);
+
+        // connect the queries to the cache
+        addCoupling(job_stream->out, cache->dbcache_in);
+    }
+};
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main()
+	#endif
+	{
+	
+		auto model = std::make_shared<test_dbcache_coupled>("test_dbcache");
+		
+		#ifdef SIM_TIME
+			auto rootCoordinator = cadmium::RootCoordinator(model);
+		#else
+			#ifdef ESP_PLATFORM
+				cadmium::ESPclock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+			#else
+				cadmium::ChronoClock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+			#endif
+		#endif
+
+		#ifndef NO_LOGGING
+			rootCoordinator.setLogger<STDOUTLogger>(";");
+			rootCoordinator.setLogger<CSVLogger>("simulation_results/dbcache_output.csv", ";");
+		#endif
+
+		rootCoordinator.start();
+		
+		#ifdef ESP_PLATFORM
+			rootCoordinator.simulate(std::numeric_limits<double>::infinity());
+		#else
+			rootCoordinator.simulate(5.0);
+		#endif
+		
+		rootCoordinator.stop();	
+
+		#ifndef ESP_PLATFORM
+			return 0;
+		#endif
+	}
+}
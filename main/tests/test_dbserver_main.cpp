@@ -25,15 +25,21 @@ Test main file for the dbserver atomic model
 	#include "cadmium/simulation/logger/csv.hpp"
 #endif
 
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
 using namespace cadmium;
 
 struct test_dbserver_coupled : public Coupled {
     test_dbserver_coupled(const std::string& id) : Coupled(id) {
 
-        // create IEStream component to read server_ids from CSV file
-        auto job_stream = addComponent<lib::IEStream<int>>("job_stream", "<ABSOLUTE_PATH>/main/test_inputs/Input_In_DBServer_Testing.csv");
+        // create IEStream component to read the jobs (id, class, server) from CSV file
+        auto job_stream = addComponent<lib::IEStream<job>>("job_stream", TEST_INPUTS_DIR "/Input_In_DBServer_Testing.csv");
         
-        auto dbs = addComponent<dbserver>("db_server", 0.5);
+        // strict priority: the class 0 job of server 3 is served before the class 1 job of server 2
+        auto dbs = addComponent<dbserver>("db_server", 0.5, "simulation_results/dbserver_log.txt", queueConfig{queueDiscipline::strict_priority});
         
 		// connect IEStream directly to dbserver input
         addCoupling(job_stream->out, dbs->dbserver_in);
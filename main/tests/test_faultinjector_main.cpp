@@ -0,0 +1,98 @@
+/*
+Test main file for the fault injector atomic model: crashes server 1 while it processes job 1,
+so job 2 is dropped, then recovers it before job 3 arrives
+*/
+
+#include <limits>
+#include "cadmium/modeling/devs/coupled.hpp"
+#include "cadmium/lib/iestream.hpp"
+#include "../atomic_models/server.hpp"
+#include "../atomic_models/faultinjector.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#ifdef ESP_PLATFORM
+		#include <cadmium/simulation/rt_clock/ESPclock.hpp>
+	#else
+		#include <cadmium/simulation/rt_clock/chrono.hpp>
+	#endif
+#endif
+
+#ifndef NO_LOGGING
+	#include "cadmium/simulation/logger/stdout.hpp"
+	#include "cadmium/simulation/logger/csv.hpp"
+#endif
+
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
+using namespace cadmium;
+
+struct test_faultinjector_coupled : public Coupled {
+    test_faultinjector_coupled(const std::string& id) : Coupled(id) {
+
+        // create IEStream component to read the jobs (0.1, 0.2, 0.3) from a CSV file
+        auto job_stream = addComponent<lib::IEStream<job>>("job_stream", TEST_INPUTS_DIR "/Input_In_Server_Testing.csv");
+
+		// crash server 1 at 0.15 and recover it at 0.25
+        faultConfig faults;
+        faults.schedule = {{0.15, 1, serverStatus::down}, {0.25, 1, serverStatus::up}};
+
+		// model name, faults, number of servers, log path
+        auto inj = addComponent<faultinjector>("fault_injector", faults, 1, "simulation_results/faultinjector_log.txt");
+
+		// model name, server id, mean processing time, log path
+        auto srv = addComponent<server>("server", 1, 0.5, "simulation_results/faultinjector_log.txt");
+        
+        // connect the jobs and the commands to the server
+        addCoupling(job_stream->out, srv->server_in);
+        addCoupling(inj->faultinjector_out1, srv->server_in_ctrl);
+    }
+};
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main()
+	#endif
+	{
+	
+		auto model = std::make_shared<test_faultinjector_coupled>("test_faultinjector");
+		
+		#ifdef SIM_TIME
+			auto rootCoordinator = cadmium::RootCoordinator(model);
+		#else
+			#ifdef ESP_PLATFORM
+				cadmium::ESPclock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+			#else
+				cadmium::ChronoClock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+			#endif
+		#endif
+
+		#ifndef NO_LOGGING
+			rootCoordinator.setLogger<STDOUTLogger>(";");
+			rootCoordinator.setLogger<CSVLogger>("simulation_results/faultinjector_output.csv", ";");
+		#endif
+
+		rootCoordinator.start();
+		
+		#ifdef ESP_PLATFORM
+			rootCoordinator.simulate(std::numeric_limits<double>::infinity());
+		#else
+			rootCoordinator.simulate(std::numeric_limits<double>::infinity());
+		#endif
+		
+		rootCoordinator.stop();	
+
+		#ifndef ESP_PLATFORM
+			return 0;
+		#endif
+	}
+}
@@ -0,0 +1,114 @@
+/*
+Test main file for the flattened TOP model.
+Runs the same configuration through the generic Top_coupled and through Flat_top,
+counts the transitions each engine executes and reports the transitions processed
+per second of wall-clock time, and their ratio. The console lines of the models are
+muted while the engines are timed, so the difference is the cost of the routing.
+*/
+
+#include <limits>
+#include <chrono>
+#include <iostream>
+#include "../Top_model/top.hpp"
+#include "../Top_model/flat_top.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#ifdef ESP_PLATFORM
+		#include <cadmium/simulation/rt_clock/ESPclock.hpp>
+	#else
+		#include <cadmium/simulation/rt_clock/chrono.hpp>
+	#endif
+#endif
+
+using namespace cadmium;
+
+// Cadmium logger that only counts the state changes (one per transition, plus the
+// initial state of every atomic model at start)
+class transitionCounter : public Logger {
+	public:
+	unsigned long* count;
+
+	explicit transitionCounter(unsigned long* counter) : count(counter) { }
+
+	void start() override { }
+	void stop() override { }
+	void logOutput(double, long, const std::string&, const std::string&, const std::string&) override { }
+	void logState(double, long, const std::string&, const std::string&) override { (*count)++; }
+};
+
+// runs the generic model to the horizon; returns the wall-clock time, and the number
+// of transitions in `transitions` when it is not null
+double runGeneric(unsigned int seed, double horizon, const std::string& log_path, unsigned long* transitions) {
+	auto model = std::make_shared<Top_coupled>("Top_coupled", log_path, seed);
+
+	#ifdef SIM_TIME
+		auto rootCoordinator = cadmium::RootCoordinator(model);
+	#else
+		#ifdef ESP_PLATFORM
+			cadmium::ESPclock clock;
+			auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+		#else
+			cadmium::ChronoClock clock;
+			auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+		#endif
+	#endif
+
+	unsigned long states = 0;
+	if (transitions != nullptr) {
+		rootCoordinator.setLogger<transitionCounter>(&states);
+	}
+	auto begin = std::chrono::steady_clock::now();
+	rootCoordinator.start();
+	unsigned long initial = states;
+	rootCoordinator.simulate(horizon);
+	rootCoordinator.stop();
+	auto end = std::chrono::steady_clock::now();
+	if (transitions != nullptr) {
+		*transitions = states - initial;
+	}
+	return std::chrono::duration<double>(end - begin).count();
+}
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main()
+	#endif
+	{
+		// both models use the same seed so they follow the same trajectory
+		const unsigned int seed = 1234;
+		const double horizon = 3600.1;
+
+		std::cout.setstate(std::ios::failbit);
+
+		// counting pass: the logger is not part of the timed runs
+		unsigned long generic_events = 0;
+		runGeneric(seed, horizon, "/dev/null", &generic_events);
+
+		double generic_s = runGeneric(seed, horizon, "simulation_results/flat_top_generic_log.txt", nullptr);
+
+		Flat_top<> flat("simulation_results/flat_top_log.txt", seed);
+		auto flat_begin = std::chrono::steady_clock::now();
+		flat.start();
+		flat.simulate(horizon);
+		auto flat_end = std::chrono::steady_clock::now();
+		double flat_s = std::chrono::duration<double>(flat_end - flat_begin).count();
+
+		std::cout.clear();
+
+		double generic_rate = static_cast<double>(generic_events) / generic_s;
+		double flat_rate = static_cast<double>(flat.getEvents()) / flat_s;
+		std::cerr << "Transitions: generic " << generic_events << ", flat " << flat.getEvents() << ", jobs out: " << flat.getJobsOut() << std::endl;
+		std::cerr << "Generic Top_coupled: " << generic_s << " s, " << generic_rate << " transitions/s" << std::endl;
+		std::cerr << "Flat_top:            " << flat_s << " s, " << flat_rate << " transitions/s" << std::endl;
+		std::cerr << "Flat_top / generic:  " << flat_rate / generic_rate << "x" << std::endl;
+
+		#ifndef ESP_PLATFORM
+			return generic_events == flat.getEvents() ? 0 : 1;
+		#endif
+	}
+}
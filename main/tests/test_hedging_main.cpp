@@ -0,0 +1,136 @@
+/*
+Test main file for request hedging over network links.
+Runs a pool with hedging and a dispatch link latency, so that duplicates are often
+still on the link when the other copy finishes, and checks that every job leaves
+the pool once: a copy in transit must be cancelled on the link. The flattened model
+must deliver as many jobs as the generic one.
+*/
+
+#include <set>
+#include <limits>
+#include <iostream>
+#include "../Top_model/top.hpp"
+#include "../Top_model/flat_top.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#ifdef ESP_PLATFORM
+		#include <cadmium/simulation/rt_clock/ESPclock.hpp>
+	#else
+		#include <cadmium/simulation/rt_clock/chrono.hpp>
+	#endif
+#endif
+
+using namespace cadmium;
+
+// ids of the jobs that left the pool, and how many left more than once
+struct jobSinkState {
+	std::set<int> seen;
+	int delivered;
+	int duplicates;
+
+	explicit jobSinkState() : delivered(0), duplicates(0) { }
+};
+
+#ifndef NO_LOGGING
+std::ostream& operator<<(std::ostream& out, const jobSinkState& state) {
+	out << "{delivered: " << state.delivered << ", duplicates: " << state.duplicates << "}";
+	return out;
+}
+#endif
+
+// Passive model recording the jobs it receives
+class jobSink : public Atomic<jobSinkState> {
+	public:
+
+	Port<job> sink_in;
+
+	explicit jobSink(const std::string& id) : Atomic<jobSinkState>(id, jobSinkState()) {
+		sink_in = addInPort<job>("sink_in");
+	}
+
+	void internalTransition([[maybe_unused]] jobSinkState& state) const override { }
+
+	void externalTransition(jobSinkState& state, [[maybe_unused]] double e) const override {
+		for (const auto& msg : sink_in->getBag()) {
+			state.delivered++;
+			if (!state.seen.insert(msg.id).second) {
+				state.duplicates++;
+				std::cerr << "job# " << msg << " left the pool twice" << std::endl;
+			}
+		}
+	}
+
+	void output([[maybe_unused]] const jobSinkState& state) const override { }
+
+	[[nodiscard]] double timeAdvance([[maybe_unused]] const jobSinkState& state) const override {
+		return std::numeric_limits<double>::infinity();
+	}
+
+	[[nodiscard]] const jobSinkState& getState() const { return state; }
+};
+
+struct test_hedging_coupled : public Coupled {
+	std::shared_ptr<jobSink> sink;
+
+	test_hedging_coupled(const std::string& id, const topConfig& config, unsigned int seed) : Coupled(id) {
+		auto top = addComponent<Top_coupled>("Top_coupled", config, "simulation_results/hedging_test_log.txt", seed);
+		sink = addComponent<jobSink>("sink");
+		addCoupling(top->out, sink->sink_in);
+	}
+};
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main()
+	#endif
+	{
+		const unsigned int seed = 1234;
+		const double horizon = 600.1;
+
+		// about 55% load, most jobs hedged after 0.3 s, 0.5 s on the link to each server
+		topConfig config;
+		config.interarrival = 0.3;
+		config.arrival_type = distributionType::exponential;
+		config.lbs.dispatch_time = 0.05;
+		config.lbs.policy = balancerPolicy::weighted_least_loaded;
+		config.lbs.db_time = 0.05;
+		config.lbs.hedging.enabled = true;
+		config.lbs.hedging.delay = 0.3;
+		config.lbs.hedging.budget = 0.5;
+		config.lbs.dispatch_link.latency = 0.5;
+
+		auto model = std::make_shared<test_hedging_coupled>("test_hedging", config, seed);
+
+		#ifdef SIM_TIME
+			auto rootCoordinator = cadmium::RootCoordinator(model);
+		#else
+			#ifdef ESP_PLATFORM
+				cadmium::ESPclock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+			#else
+				cadmium::ChronoClock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+			#endif
+		#endif
+
+		rootCoordinator.start();
+		rootCoordinator.simulate(horizon);
+		rootCoordinator.stop();
+
+		Flat_top<> flat(config, "simulation_results/hedging_test_flat_log.txt", seed);
+		flat.start();
+		flat.simulate(horizon);
+
+		const jobSinkState& result = model->sink->getState();
+		std::cerr << "Jobs out: generic " << result.delivered << " (" << result.duplicates << " twice), flat " << flat.getJobsOut() << std::endl;
+
+		#ifndef ESP_PLATFORM
+			return (result.duplicates == 0 && result.delivered > 0 && static_cast<unsigned long>(result.delivered) == flat.getJobsOut()) ? 0 : 1;
+		#endif
+	}
+}
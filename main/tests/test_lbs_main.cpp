@@ -24,6 +24,11 @@ Test main file for the LBS coupled model.
 	#include "cadmium/simulation/logger/csv.hpp"
 #endif
 
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
 using namespace cadmium;
 
 
@@ -31,7 +36,7 @@ struct test_lbs_coupled : public Coupled {
     test_lbs_coupled(const std::string& id) : Coupled(id) {
 		
         // create IEStream component to read int from CSV file
-        auto job_stream = addComponent<lib::IEStream<int>>("In", "<ABSOLUTE_PATH>/main/test_inputs/Input_In_LBS_Testing.csv");
+        auto job_stream = addComponent<lib::IEStream<job>>("In", TEST_INPUTS_DIR "/Input_In_LBS_Testing.csv");
         auto lbs = addComponent<LBS>("LBS", "simulation_results/lbs_log.txt");  
         
         // connect IEStream output to LBS input
@@ -23,14 +23,19 @@ Test main file for the server atomic model
 	#include "cadmium/simulation/logger/csv.hpp"
 #endif
 
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
 using namespace cadmium;
 
 struct test_server_coupled : public Coupled {
     test_server_coupled(const std::string& id) : Coupled(id) {
 
         // create IEStream components to read from CSV files
-        auto job_stream = addComponent<lib::IEStream<int>>("job_stream", "<ABSOLUTE_PATH>/main/test_inputs/Input_In_Server_Testing.csv");
-        auto db_stream = addComponent<lib::IEStream<int>>("db_stream", "<ABSOLUTE_PATH>/main/test_inputs/Input_Indb_Server_Testing.csv");
+        auto job_stream = addComponent<lib::IEStream<job>>("job_stream", TEST_INPUTS_DIR "/Input_In_Server_Testing.csv");
+        auto db_stream = addComponent<lib::IEStream<job>>("db_stream", TEST_INPUTS_DIR "/Input_Indb_Server_Testing.csv");
         
 		// model name, server id, mean processing time
         auto srv = addComponent<server>("server", 1, 0.5);
@@ -0,0 +1,96 @@
+/*
+Test main file for the WAN link atomic model: a link with a latency of 0.5 that takes 0.1 to send a job
+and carries one job at a time delivers job 1 (sent at t = 1) at t = 1.6 and job 2 (t = 1.2, waits for job 1)
+at t = 2.2, then job 3 (t = 3) at t = 3.6 and job 4 (t = 3, waits for job 3) at t = 4.2
+*/
+
+#include <limits>
+#include "cadmium/modeling/devs/coupled.hpp"
+#include "cadmium/lib/iestream.hpp"
+#include "../atomic_models/wanlink.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#ifdef ESP_PLATFORM
+		#include <cadmium/simulation/rt_clock/ESPclock.hpp>
+	#else
+		#include <cadmium/simulation/rt_clock/chrono.hpp>
+	#endif
+#endif
+
+#ifndef NO_LOGGING
+	#include "cadmium/simulation/logger/stdout.hpp"
+	#include "cadmium/simulation/logger/csv.hpp"
+#endif
+
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
+using namespace cadmium;
+
+struct test_wanlink_coupled : public Coupled {
+    test_wanlink_coupled(const std::string& id) : Coupled(id) {
+
+        // create IEStream component to read the jobs sent over the link from a CSV file
+        auto job_stream = addComponent<lib::IEStream<job>>("job_stream", TEST_INPUTS_DIR "/Input_In_Wanlink_Testing.csv");
+
+		// jobs of size 1 sent at 10 per unit of time, one at a time on the link, 0.5 to propagate
+        linkConfig network;
+        network.latency = 0.5;
+        network.bandwidth = 10;
+        network.capacity = 1;
+
+		// model name, link parameters, log path, rng seed
+        auto wire = addComponent<wanlink>("wan_link", network, "simulation_results/wanlink_log.txt", 1234);
+
+        // connect the jobs to the link
+        addCoupling(job_stream->out, wire->wanlink_in);
+    }
+};
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main()
+	#endif
+	{
+	
+		auto model = std::make_shared<test_wanlink_coupled>("test_wanlink");
+		
+		#ifdef SIM_TIME
+			auto rootCoordinator = cadmium::RootCoordinator(model);
+		#else
+			#ifdef ESP_PLATFORM
+				cadmium::ESPclock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+			#else
+				cadmium::ChronoClock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+			#endif
+		#endif
+
+		#ifndef NO_LOGGING
+			rootCoordinator.setLogger<STDOUTLogger>(";");
+			rootCoordinator.setLogger<CSVLogger>("simulation_results/wanlink_output.csv", ";");
+		#endif
+
+		rootCoordinator.start();
+		
+		#ifdef ESP_PLATFORM
+			rootCoordinator.simulate(std::numeric_limits<double>::infinity());
+		#else
+			rootCoordinator.simulate(5.0);
+		#endif
+		
+		rootCoordinator.stop();	
+
+		#ifndef ESP_PLATFORM
+			return 0;
+		#endif
+	}
+}
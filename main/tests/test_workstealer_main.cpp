@@ -0,0 +1,94 @@
+/*
+Test main file for the work stealer atomic model: jobs keep arriving at server 1 and never finish,
+so idle server 2 steals one as soon as server 1 holds two jobs (t = 1) and idle server 3 does the same at t = 1.5
+*/
+
+#include <limits>
+#include "cadmium/modeling/devs/coupled.hpp"
+#include "cadmium/lib/iestream.hpp"
+#include "../atomic_models/workstealer.hpp"
+
+#ifdef SIM_TIME
+	#include "cadmium/simulation/root_coordinator.hpp"
+#else
+	#include "cadmium/simulation/rt_root_coordinator.hpp"
+	#ifdef ESP_PLATFORM
+		#include <cadmium/simulation/rt_clock/ESPclock.hpp>
+	#else
+		#include <cadmium/simulation/rt_clock/chrono.hpp>
+	#endif
+#endif
+
+#ifndef NO_LOGGING
+	#include "cadmium/simulation/logger/stdout.hpp"
+	#include "cadmium/simulation/logger/csv.hpp"
+#endif
+
+// absolute path of the CSV inputs (IEStream requires absolute paths), set by CMake
+#ifndef TEST_INPUTS_DIR
+	#define TEST_INPUTS_DIR "<ABSOLUTE_PATH>/main/test_inputs"
+#endif
+
+using namespace cadmium;
+
+struct test_workstealer_coupled : public Coupled {
+    test_workstealer_coupled(const std::string& id) : Coupled(id) {
+
+        // create IEStream component to read the jobs dispatched to server 1 from a CSV file
+        auto job_stream = addComponent<lib::IEStream<job>>("job_stream", TEST_INPUTS_DIR "/Input_In_Workstealer_Testing.csv");
+
+		// an idle server steals from a peer holding at least 2 jobs
+        stealConfig stealing;
+        stealing.enabled = true;
+        stealing.threshold = 2;
+
+		// model name, stealing parameters, number of servers, active servers, log path
+        auto stealer = addComponent<workstealer>("work_stealer", stealing, 3, 3, "simulation_results/workstealer_log.txt");
+
+        // connect the jobs to the work stealer
+        addCoupling(job_stream->out, stealer->workstealer_in_dispatched1);
+    }
+};
+
+extern "C" {
+	#ifdef ESP_PLATFORM
+		void app_main()
+	#else
+		int main()
+	#endif
+	{
+	
+		auto model = std::make_shared<test_workstealer_coupled>("test_workstealer");
+		
+		#ifdef SIM_TIME
+			auto rootCoordinator = cadmium::RootCoordinator(model);
+		#else
+			#ifdef ESP_PLATFORM
+				cadmium::ESPclock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ESPclock<double>>(model, clock);
+			#else
+				cadmium::ChronoClock clock;
+				auto rootCoordinator = cadmium::RealTimeRootCoordinator<cadmium::ChronoClock<std::chrono::steady_clock>>(model, clock);
+			#endif
+		#endif
+
+		#ifndef NO_LOGGING
+			rootCoordinator.setLogger<STDOUTLogger>(";");
+			rootCoordinator.setLogger<CSVLogger>("simulation_results/workstealer_output.csv", ";");
+		#endif
+
+		rootCoordinator.start();
+		
+		#ifdef ESP_PLATFORM
+			rootCoordinator.simulate(std::numeric_limits<double>::infinity());
+		#else
+			rootCoordinator.simulate(5.0);
+		#endif
+		
+		rootCoordinator.stop();	
+
+		#ifndef ESP_PLATFORM
+			return 0;
+		#endif
+	}
+}
@@ -0,0 +1,179 @@
+#ifndef CLASSQUEUE_HPP
+#define CLASSQUEUE_HPP
+
+#include <array>
+#include <queue>
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include "job.hpp"
+#include "snapshot.hpp"
+
+// Order in which the queued jobs of the different classes are served
+enum class queueDiscipline {
+    fifo,             // arrival order, whatever the class
+    strict_priority,  // lowest class first, FIFO within a class
+    weighted_fair     // smooth weighted round-robin over the classes with queued jobs
+};
+
+inline const char* disciplineName(queueDiscipline discipline) {
+    switch (discipline) {
+        case queueDiscipline::strict_priority: return "strict_priority";
+        case queueDiscipline::weighted_fair: return "weighted_fair";
+        default: return "fifo";
+    }
+}
+
+inline bool parseDiscipline(const std::string& name, queueDiscipline& discipline) {
+    if (name == "fifo") {
+        discipline = queueDiscipline::fifo;
+    } else if (name == "strict_priority") {
+        discipline = queueDiscipline::strict_priority;
+    } else if (name == "weighted_fair") {
+        discipline = queueDiscipline::weighted_fair;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+struct queueConfig {
+    queueDiscipline discipline = queueDiscipline::fifo;
+    std::array<double, job::MAX_CLASSES> weights = {1, 1, 1, 1};  // share of each class under weighted_fair
+};
+
+// One FIFO per job class; pop() picks the class to serve from the discipline.
+// T is checkpointed field by field through its save() and restore() members.
+template<typename T>
+class classQueue {
+    public:
+
+    static constexpr int MAX_CLASSES = job::MAX_CLASSES;
+
+    void push(int cls, const T& item) {
+        queues[cls].push({next_seq++, item});
+    }
+
+    // class served next (-1 if empty)
+    [[nodiscard]] int select(const queueConfig& config) const {
+        int best = -1;
+        for (int c = 0; c < MAX_CLASSES; c++) {
+            if (queues[c].empty()) {
+                continue;
+            }
+            if (best < 0) {
+                best = c;
+            } else if (config.discipline == queueDiscipline::fifo && queues[c].front().seq < queues[best].front().seq) {
+                best = c;
+            } else if (config.discipline == queueDiscipline::weighted_fair && credit[c] + config.weights[c] > credit[best] + config.weights[best]) {
+                best = c;
+            }
+        }
+        return best;
+    }
+
+    // removes and returns the next item; the queue must not be empty
+    T pop(const queueConfig& config) {
+        int cls = select(config);
+        if (config.discipline == queueDiscipline::weighted_fair) {
+            double total = 0.0;
+            for (int c = 0; c < MAX_CLASSES; c++) {
+                if (!queues[c].empty()) {
+                    credit[c] += config.weights[c];
+                    total += config.weights[c];
+                }
+            }
+            credit[cls] -= total;
+        }
+        T item = queues[cls].front().item;
+        queues[cls].pop();
+        return item;
+    }
+
+    // oldest queued item of class cls; the class must not be empty
+    [[nodiscard]] const T& front(int cls) const {
+        return queues[cls].front().item;
+    }
+
+    // removes the first queued item of class cls matching pred; false if there is none
+    template<typename Pred>
+    bool remove(int cls, Pred pred) {
+        std::queue<entry> kept;
+        bool found = false;
+        for (; !queues[cls].empty(); queues[cls].pop()) {
+            if (!found && pred(queues[cls].front().item)) {
+                found = true;
+            } else {
+                kept.push(queues[cls].front());
+            }
+        }
+        queues[cls] = std::move(kept);
+        return found;
+    }
+
+    [[nodiscard]] bool empty() const {
+        return size() == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        std::size_t n = 0;
+        for (const auto& q : queues) {
+            n += q.size();
+        }
+        return n;
+    }
+
+    [[nodiscard]] std::size_t size(int cls) const {
+        return queues[cls].size();
+    }
+
+    void clear() {
+        for (auto& q : queues) {
+            q = std::queue<entry>();
+        }
+    }
+
+    void save(std::ostream& os) const {
+        for (auto q : queues) {
+            snapshot::write(os, static_cast<std::uint64_t>(q.size()));
+            for (; !q.empty(); q.pop()) {
+                snapshot::write(os, q.front().seq);
+                q.front().item.save(os);
+            }
+        }
+        snapshot::write(os, credit);
+        snapshot::write(os, next_seq);
+    }
+
+    bool restore(std::istream& is) {
+        for (auto& q : queues) {
+            std::uint64_t size = 0;
+            if (!snapshot::read(is, size)) {
+                return false;
+            }
+            q = std::queue<entry>();
+            for (std::uint64_t i = 0; i < size; i++) {
+                entry e{};
+                if (!snapshot::read(is, e.seq) || !e.item.restore(is)) {
+                    return false;
+                }
+                q.push(e);
+            }
+        }
+        return snapshot::read(is, credit) && snapshot::read(is, next_seq);
+    }
+
+    private:
+
+    struct entry {
+        std::uint64_t seq;  // arrival order across the classes
+        T item;
+    };
+
+    std::array<std::queue<entry>, MAX_CLASSES> queues;
+    std::array<double, MAX_CLASSES> credit{};  // weighted_fair counters
+    std::uint64_t next_seq = 0;
+};
+
+#endif
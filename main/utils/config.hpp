@@ -0,0 +1,203 @@
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+// Minimal INI reader for scenario files:
+//
+//   # comment            ; comment
+//   [section]
+//   key = value
+//   list = 0.5, 0.5, 1
+//
+// Keys are looked up as (section, key). Every key that is read is recorded, so
+// keys that no model understands (usually typos) can be reported after loading.
+class iniConfig {
+    public:
+
+    bool load(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open scenario file: " << path << std::endl;
+            return false;
+        }
+        file_path = path;
+
+        std::string line;
+        std::string section;
+        int line_number = 0;
+        bool ok = true;
+        while (std::getline(file, line)) {
+            line_number++;
+            line = trim(stripComment(line));
+            if (line.empty()) {
+                continue;
+            }
+            if (line.front() == '[') {
+                if (line.back() != ']') {
+                    std::cerr << "Error: " << path << ":" << line_number << ": unterminated section header" << std::endl;
+                    ok = false;
+                    continue;
+                }
+                section = trim(line.substr(1, line.size() - 2));
+                continue;
+            }
+            auto eq = line.find('=');
+            if (eq == std::string::npos) {
+                std::cerr << "Error: " << path << ":" << line_number << ": expected key = value" << std::endl;
+                ok = false;
+                continue;
+            }
+            values[section + "." + trim(line.substr(0, eq))] = trim(line.substr(eq + 1));
+        }
+        return ok;
+    }
+
+    [[nodiscard]] bool has(const std::string& section, const std::string& key) const {
+        return values.count(section + "." + key) != 0;
+    }
+
+    std::string getString(const std::string& section, const std::string& key, const std::string& fallback) {
+        auto it = find(section, key);
+        return it == values.end() ? fallback : it->second;
+    }
+
+    double getDouble(const std::string& section, const std::string& key, double fallback) {
+        auto it = find(section, key);
+        if (it == values.end()) {
+            return fallback;
+        }
+        double value = fallback;
+        if (!parse(it->second, value)) {
+            invalid(it->first, it->second, "a number");
+        }
+        return value;
+    }
+
+    int getInt(const std::string& section, const std::string& key, int fallback) {
+        auto it = find(section, key);
+        if (it == values.end()) {
+            return fallback;
+        }
+        int value = fallback;
+        if (!parse(it->second, value)) {
+            invalid(it->first, it->second, "an integer");
+        }
+        return value;
+    }
+
+    bool getBool(const std::string& section, const std::string& key, bool fallback) {
+        auto it = find(section, key);
+        if (it == values.end()) {
+            return fallback;
+        }
+        if (it->second == "true" || it->second == "yes" || it->second == "on" || it->second == "1") {
+            return true;
+        }
+        if (it->second == "false" || it->second == "no" || it->second == "off" || it->second == "0") {
+            return false;
+        }
+        invalid(it->first, it->second, "true or false");
+        return fallback;
+    }
+
+    // comma separated list of numbers; a single value is a list of one
+    std::vector<double> getDoubles(const std::string& section, const std::string& key, const std::vector<double>& fallback) {
+        auto it = find(section, key);
+        if (it == values.end()) {
+            return fallback;
+        }
+        std::vector<double> list;
+        std::stringstream ss(it->second);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            double value = 0.0;
+            if (!parse(trim(item), value)) {
+                invalid(it->first, it->second, "a list of numbers");
+                return fallback;
+            }
+            list.push_back(value);
+        }
+        return list;
+    }
+
+    // comma separated list of words, e.g. policy names
+    std::vector<std::string> getStrings(const std::string& section, const std::string& key, const std::vector<std::string>& fallback) {
+        auto it = find(section, key);
+        if (it == values.end()) {
+            return fallback;
+        }
+        std::vector<std::string> list;
+        std::stringstream ss(it->second);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            list.push_back(trim(item));
+        }
+        return list;
+    }
+
+    // reports keys of the file that were never read; returns true if there are none
+    bool checkUnused() const {
+        bool ok = true;
+        for (const auto& entry : values) {
+            if (used.count(entry.first) == 0) {
+                std::cerr << "Warning: " << file_path << ": unknown key " << entry.first << std::endl;
+                ok = false;
+            }
+        }
+        return ok;
+    }
+
+    [[nodiscard]] bool valid() const { return errors == 0; }
+
+    private:
+
+    std::string file_path;
+    std::map<std::string, std::string> values;
+    std::set<std::string> used;
+    int errors = 0;
+
+    std::map<std::string, std::string>::const_iterator find(const std::string& section, const std::string& key) {
+        std::string name = section + "." + key;
+        used.insert(name);
+        return values.find(name);
+    }
+
+    void invalid(const std::string& name, const std::string& value, const char* expected) {
+        std::cerr << "Error: " << file_path << ": " << name << " = " << value << " is not " << expected << std::endl;
+        errors++;
+    }
+
+    template<typename T>
+    static bool parse(const std::string& text, T& value) {
+        std::stringstream ss(text);
+        T parsed;
+        if (!(ss >> parsed) || !(ss >> std::ws).eof()) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    static std::string stripComment(const std::string& line) {
+        auto pos = line.find_first_of("#;");
+        return pos == std::string::npos ? line : line.substr(0, pos);
+    }
+
+    static std::string trim(const std::string& text) {
+        auto first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos) {
+            return "";
+        }
+        auto last = text.find_last_not_of(" \t\r\n");
+        return text.substr(first, last - first + 1);
+    }
+};
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef CONTROL_HPP
+#define CONTROL_HPP
+
+#include <iostream>
+
+// Control messages exchanged by the models, besides the jobs
+
+// Status of a server; the values are the commands accepted on server_in_ctrl
+enum class serverStatus : int {
+    up = 0,        // serves and accepts jobs
+    down = 1,      // crashed: queued jobs are lost, arriving jobs are dropped
+    draining = 2   // finishes its jobs, should not receive new ones
+};
+
+inline const char* statusName(serverStatus status) {
+    switch (status) {
+        case serverStatus::down: return "down";
+        case serverStatus::draining: return "draining";
+        default: return "up";
+    }
+}
+
+// One job moved from a server to an idle peer
+struct stealRequest {
+    int victim;  // 1 to MAX_SERVERS
+    int thief;
+};
+
+inline std::ostream& operator<<(std::ostream& out, const stealRequest& request) {
+    out << request.victim << " -> " << request.thief;
+    return out;
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef DISTRIBUTION_HPP
+#define DISTRIBUTION_HPP
+
+#include <string>
+
+// Distributions selectable for the generator inter-arrival time and the server processing time
+enum class distributionType {
+    constant,     // always the mean
+    exponential   // exponential with the given mean
+};
+
+inline const char* distributionName(distributionType type) {
+    return type == distributionType::exponential ? "exponential" : "constant";
+}
+
+inline bool parseDistribution(const std::string& name, distributionType& type) {
+    if (name == "constant") {
+        type = distributionType::constant;
+    } else if (name == "exponential") {
+        type = distributionType::exponential;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+#endif
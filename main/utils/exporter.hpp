@@ -0,0 +1,143 @@
+#ifndef EXPORTER_HPP
+#define EXPORTER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <cstdint>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include "metrics.hpp"
+
+#ifndef MSG_NOSIGNAL
+    #define MSG_NOSIGNAL 0  // no such flag outside Linux
+#endif
+
+// Prometheus-style text endpoint on 127.0.0.1: a thread answers every HTTP request
+// (e.g. GET /metrics) with the latest published sample. Samples are only worth
+// building while someone reads them, so wanted() is false once no request came in
+// for IDLE seconds of wall-clock time (and true for the first IDLE seconds, so the
+// first request finds a sample).
+class metricsExporter {
+    public:
+
+    static constexpr double IDLE = 60;
+
+    explicit metricsExporter(const metricsConfig& cfg) : config(cfg), last_request(now()) {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(config.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int reuse = 1;
+        if (fd < 0 || ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0
+            || ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(fd, 8) != 0) {
+            std::cerr << "Warning: Could not serve metrics on 127.0.0.1:" << config.port << std::endl;
+            if (fd >= 0) {
+                ::close(fd);
+                fd = -1;
+            }
+            return;
+        }
+        text = "# no sample yet\n";
+        server = std::thread([this]() { serve(); });
+    }
+
+    metricsExporter(const metricsExporter&) = delete;
+    metricsExporter& operator=(const metricsExporter&) = delete;
+
+    ~metricsExporter() {
+        stopping = true;
+        if (server.joinable()) {
+            server.join();
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+
+    [[nodiscard]] bool enabled() const {
+        return fd >= 0;
+    }
+
+    // true while a client reads the metrics
+    [[nodiscard]] bool wanted() const {
+        return enabled() && now() - last_request.load() < IDLE;
+    }
+
+    // replaces the sample the endpoint serves
+    void publish(const metricsSample& sample) {
+        std::ostringstream os;
+        writeMetrics(os, sample, previous);
+        previous = sample;
+        std::lock_guard<std::mutex> lock(mutex);
+        text = os.str();
+    }
+
+    private:
+
+    metricsConfig config;
+    int fd = -1;
+    std::thread server;
+    std::atomic<bool> stopping{false};
+    std::atomic<double> last_request;
+    std::mutex mutex;
+    std::string text;          // latest sample, in the text format
+    metricsSample previous;    // sample the rates of the next one are taken over
+
+    static double now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // one request per connection; polls so that the destructor can stop the thread
+    void serve() {
+        while (!stopping) {
+            pollfd listening{fd, POLLIN, 0};
+            if (::poll(&listening, 1, 200) <= 0) {
+                continue;
+            }
+            int client = ::accept(fd, nullptr, nullptr);
+            if (client < 0) {
+                continue;
+            }
+            timeval limit{1, 0};
+            ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+            char buffer[1024];
+            std::string request;
+            while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+                auto n = ::recv(client, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    break;
+                }
+                request.append(buffer, static_cast<std::size_t>(n));
+            }
+            last_request = now();
+            std::string body;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                body = text;
+            }
+            std::string response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: " + std::to_string(body.size())
+                                 + "\r\nConnection: close\r\n\r\n" + body;
+            std::size_t sent = 0;
+            while (sent < response.size()) {
+                auto n = ::send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    break;
+                }
+                sent += static_cast<std::size_t>(n);
+            }
+            ::close(client);
+        }
+    }
+};
+
+#endif
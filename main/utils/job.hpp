@@ -0,0 +1,65 @@
+#ifndef JOB_HPP
+#define JOB_HPP
+
+#include <iostream>
+#include <cctype>
+#include "snapshot.hpp"
+
+// Message carried by the job ports, from the generator to the servers and the DB server
+struct job {
+    static constexpr int MAX_CLASSES = 4;
+
+    int id = 0;
+    int job_class = 0;  // 0 is the highest priority
+    int server = 0;     // server that processes the job, set when it is sent to the DB server
+    int session = 0;    // session the job belongs to, 0 for none
+
+    job() = default;
+    job(int job_id, int cls = 0, int srv = 0, int sess = 0) : id(job_id), job_class(cls), server(srv), session(sess) { }
+
+    // key of the session affinity: the session, or the job itself when it has none
+    [[nodiscard]] int affinityKey() const {
+        return session != 0 ? session : id;
+    }
+
+    void save(std::ostream& os) const {
+        snapshot::write(os, id);
+        snapshot::write(os, job_class);
+        snapshot::write(os, server);
+        snapshot::write(os, session);
+    }
+
+    bool restore(std::istream& is) {
+        return snapshot::read(is, id) && snapshot::read(is, job_class) && snapshot::read(is, server) && snapshot::read(is, session);
+    }
+};
+
+// the id only, followed by the class for jobs that are not of class 0
+inline std::ostream& operator<<(std::ostream& out, const job& j) {
+    out << j.id;
+    if (j.job_class != 0) {
+        out << " (class " << j.job_class << ")";
+    }
+    return out;
+}
+
+// reads "id [class [server [session]]]": the optional fields must be on the same line
+inline std::istream& operator>>(std::istream& in, job& j) {
+    j = job();
+    in >> j.id;
+    for (int* field : {&j.job_class, &j.server, &j.session}) {
+        if (in.eof()) {
+            break;  // peeking past the end of a file without a final newline would fail the read
+        }
+        while (in.peek() == ' ' || in.peek() == '\t') {
+            in.get();
+        }
+        if (!std::isdigit(in.peek())) {
+            break;
+        }
+        in >> *field;
+    }
+    return in;
+}
+
+#endif
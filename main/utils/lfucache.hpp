@@ -0,0 +1,92 @@
+#ifndef LFUCACHE_HPP
+#define LFUCACHE_HPP
+
+#include <vector>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <cstdint>
+#include <iostream>
+#include "snapshot.hpp"
+
+// Least frequently used set of keys with a fixed capacity; among the keys with the
+// fewest accesses the least recently used one is evicted. Same interface as lruCache.
+class lfuCache {
+    public:
+
+    explicit lfuCache(int max_keys = 0) : capacity(max_keys) { }
+
+    // true if the key was cached; counts an access to the key
+    bool access(int key) {
+        if (capacity <= 0) {
+            return false;
+        }
+        auto it = index.find(key);
+        if (it != index.end()) {
+            order.erase({it->second.count, it->second.tick, key});
+            it->second.count++;
+            it->second.tick = ++clock;
+            order.insert({it->second.count, it->second.tick, key});
+            return true;
+        }
+        if (static_cast<int>(index.size()) >= capacity) {
+            auto victim = order.begin();  // fewest accesses, then least recently used
+            index.erase(std::get<2>(*victim));
+            order.erase(victim);
+        }
+        index[key] = {1, ++clock};
+        order.insert({1, clock, key});
+        return false;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return index.size();
+    }
+
+    void save(std::ostream& os) const {
+        std::vector<int> keys;
+        std::vector<int> counts;
+        std::vector<std::uint64_t> ticks;
+        for (const auto& [count, tick, key] : order) {
+            keys.push_back(key);
+            counts.push_back(count);
+            ticks.push_back(tick);
+        }
+        snapshot::write(os, capacity);
+        snapshot::write(os, clock);
+        snapshot::write(os, keys);
+        snapshot::write(os, counts);
+        snapshot::write(os, ticks);
+    }
+
+    bool restore(std::istream& is) {
+        std::vector<int> keys;
+        std::vector<int> counts;
+        std::vector<std::uint64_t> ticks;
+        if (!snapshot::read(is, capacity) || !snapshot::read(is, clock) || !snapshot::read(is, keys)
+            || !snapshot::read(is, counts) || !snapshot::read(is, ticks) || counts.size() != keys.size() || ticks.size() != keys.size()) {
+            return false;
+        }
+        index.clear();
+        order.clear();
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            index[keys[i]] = {counts[i], ticks[i]};
+            order.insert({counts[i], ticks[i], keys[i]});
+        }
+        return true;
+    }
+
+    private:
+
+    struct usage {
+        int count;           // accesses since the key was cached
+        std::uint64_t tick;  // time of the last access
+    };
+
+    int capacity;
+    std::uint64_t clock = 0;
+    std::unordered_map<int, usage> index;
+    std::set<std::tuple<int, std::uint64_t, int>> order;  // (count, tick, key), next victim first
+};
+
+#endif
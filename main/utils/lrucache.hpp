@@ -0,0 +1,113 @@
+#ifndef LRUCACHE_HPP
+#define LRUCACHE_HPP
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <iostream>
+#include "snapshot.hpp"
+
+// Cache model of a server: a hit makes the processing of a job shorter
+struct cacheConfig {
+    int size = 0;             // session keys the cache holds, 0 for no cache
+    double hit_factor = 0.5;  // processing time of a hit relative to a miss
+
+    [[nodiscard]] bool enabled() const {
+        return size > 0;
+    }
+};
+
+// Least recently used set of keys with a fixed capacity. The recency list is
+// kept in index-linked slots, so the cache can be copied like the other states.
+class lruCache {
+    public:
+
+    explicit lruCache(int max_keys = 0) : capacity(max_keys) { }
+
+    // true if the key was cached; the key becomes the most recently used
+    bool access(int key) {
+        if (capacity <= 0) {
+            return false;
+        }
+        auto it = index.find(key);
+        if (it != index.end()) {
+            unlink(it->second);
+            pushFront(it->second);
+            return true;
+        }
+        int slot;
+        if (static_cast<int>(slots.size()) < capacity) {
+            slot = static_cast<int>(slots.size());
+            slots.push_back({key, -1, -1});
+        } else {
+            slot = tail;  // evict the least recently used key
+            unlink(slot);
+            index.erase(slots[slot].key);
+            slots[slot].key = key;
+        }
+        index[key] = slot;
+        pushFront(slot);
+        return false;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return index.size();
+    }
+
+    // keys from the least to the most recently used; restore() replays them
+    void save(std::ostream& os) const {
+        std::vector<int> keys;
+        for (int slot = tail; slot >= 0; slot = slots[slot].prev) {
+            keys.push_back(slots[slot].key);
+        }
+        snapshot::write(os, capacity);
+        snapshot::write(os, keys);
+    }
+
+    bool restore(std::istream& is) {
+        std::vector<int> keys;
+        if (!snapshot::read(is, capacity) || !snapshot::read(is, keys)) {
+            return false;
+        }
+        *this = lruCache(capacity);
+        for (int key : keys) {
+            access(key);
+        }
+        return true;
+    }
+
+    private:
+
+    struct slotEntry {
+        int key;
+        int prev;  // more recently used
+        int next;  // less recently used
+    };
+
+    int capacity;
+    std::vector<slotEntry> slots;
+    std::unordered_map<int, int> index;  // key -> slot
+    int head = -1;                        // most recently used
+    int tail = -1;                        // least recently used
+
+    void unlink(int slot) {
+        slotEntry& e = slots[slot];
+        (e.prev >= 0 ? slots[e.prev].next : head) = e.next;
+        (e.next >= 0 ? slots[e.next].prev : tail) = e.prev;
+        e.prev = e.next = -1;
+    }
+
+    void pushFront(int slot) {
+        slots[slot].prev = -1;
+        slots[slot].next = head;
+        if (head >= 0) {
+            slots[head].prev = slot;
+        }
+        head = slot;
+        if (tail < 0) {
+            tail = slot;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "stats.hpp"
+
+// Live metrics of a run, served on localhost
+struct metricsConfig {
+    int port = 0;         // TCP port of the endpoint on 127.0.0.1, 0 for none
+    double period = 10;   // simulated seconds between two samples
+
+    [[nodiscard]] bool enabled() const {
+        return port > 0;
+    }
+};
+
+// Counters and gauges of one server at a point of the run
+struct serverSample {
+    std::string name;   // "1", or "zone/server" with regions
+    int queued;         // jobs not sent to the DB yet
+    int jobs_done;
+    int lost;
+    double busy_time;   // total processing time of the started jobs
+    bool up;
+};
+
+// Aggregated state of the model at simulation time `time`, as published by the metrics exporter
+struct metricsSample {
+    double time = 0;
+    int generated = 0;
+    int balancer_queue = 0;   // jobs waiting for or in dispatch, every balancer of the model
+    int shed = 0;
+    int rejected = 0;
+    std::vector<serverSample> servers;
+    int db_queue = 0;         // jobs at the DB, every db server of the model
+    int db_done = 0;
+    double db_busy = 0;       // time the db servers spent on round trips
+    latencyStats latency;     // server latency (arrival to DB acknowledgment) since the start
+};
+
+// Writes a sample in the Prometheus text format. Throughput and utilisations are
+// taken over the interval since `previous`, counters and latencies since the start.
+inline void writeMetrics(std::ostream& os, const metricsSample& sample, const metricsSample& previous) {
+    double dt = sample.time - previous.time;
+    auto rate = [dt](double now, double before) {
+        return dt > 0 ? (now - before) / dt : 0.0;
+    };
+    auto family = [&os](const char* name, const char* type, const char* help) {
+        os << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    };
+    auto previousServer = [&previous](std::size_t k, const std::string& name) -> const serverSample* {
+        return k < previous.servers.size() && previous.servers[k].name == name ? &previous.servers[k] : nullptr;
+    };
+
+    int done = 0;
+    int previous_done = 0;
+    for (const auto& s : sample.servers) {
+        done += s.jobs_done;
+    }
+    for (const auto& s : previous.servers) {
+        previous_done += s.jobs_done;
+    }
+
+    family("lbs_time_seconds", "gauge", "Simulated time of the sample.");
+    os << "lbs_time_seconds " << sample.time << "\n";
+    family("lbs_jobs_generated_total", "counter", "Jobs sent by the generator.");
+    os << "lbs_jobs_generated_total " << sample.generated << "\n";
+    family("lbs_jobs_done_total", "counter", "Jobs finished by the servers (DB acknowledgment received).");
+    os << "lbs_jobs_done_total " << done << "\n";
+    family("lbs_throughput_jobs_per_second", "gauge", "Jobs finished per simulated second since the previous sample.");
+    os << "lbs_throughput_jobs_per_second " << rate(done, previous_done) << "\n";
+
+    family("lbs_balancer_queue_depth", "gauge", "Jobs waiting for or in dispatch at the balancers.");
+    os << "lbs_balancer_queue_depth " << sample.balancer_queue << "\n";
+    family("lbs_balancer_shed_total", "counter", "Jobs shed on arrival (bounded memory).");
+    os << "lbs_balancer_shed_total " << sample.shed << "\n";
+    family("lbs_balancer_rejected_total", "counter", "Jobs dropped because no server was in rotation.");
+    os << "lbs_balancer_rejected_total " << sample.rejected << "\n";
+
+    family("lbs_server_queue_depth", "gauge", "Jobs at a server not sent to the DB yet.");
+    for (const auto& s : sample.servers) {
+        os << "lbs_server_queue_depth{server=\"" << s.name << "\"} " << s.queued << "\n";
+    }
+    family("lbs_server_jobs_done_total", "counter", "Jobs finished by a server.");
+    for (const auto& s : sample.servers) {
+        os << "lbs_server_jobs_done_total{server=\"" << s.name << "\"} " << s.jobs_done << "\n";
+    }
+    family("lbs_server_jobs_lost_total", "counter", "Jobs dropped by a server that crashed or was down.");
+    for (const auto& s : sample.servers) {
+        os << "lbs_server_jobs_lost_total{server=\"" << s.name << "\"} " << s.lost << "\n";
+    }
+    family("lbs_server_utilisation", "gauge", "Busy fraction of a server since the previous sample.");
+    for (std::size_t k = 0; k < sample.servers.size(); k++) {
+        const serverSample& s = sample.servers[k];
+        const serverSample* before = previousServer(k, s.name);
+        os << "lbs_server_utilisation{server=\"" << s.name << "\"} " << rate(s.busy_time, before ? before->busy_time : 0.0) << "\n";
+    }
+    family("lbs_server_up", "gauge", "1 when a server is up or draining, 0 when it is down.");
+    for (const auto& s : sample.servers) {
+        os << "lbs_server_up{server=\"" << s.name << "\"} " << (s.up ? 1 : 0) << "\n";
+    }
+
+    family("lbs_db_queue_depth", "gauge", "Jobs at the db servers, queued or in progress.");
+    os << "lbs_db_queue_depth " << sample.db_queue << "\n";
+    family("lbs_db_jobs_done_total", "counter", "Queries acknowledged by the db servers.");
+    os << "lbs_db_jobs_done_total " << sample.db_done << "\n";
+    family("lbs_db_utilisation", "gauge", "Busy fraction of the db servers since the previous sample.");
+    os << "lbs_db_utilisation " << rate(sample.db_busy, previous.db_busy) << "\n";
+
+    family("lbs_latency_seconds", "summary", "Server latency, from the arrival at a server to the DB acknowledgment.");
+    for (double q : {0.5, 0.95, 0.99}) {
+        os << "lbs_latency_seconds{quantile=\"" << q << "\"} " << sample.latency.quantile(q) << "\n";
+    }
+    os << "lbs_latency_seconds_sum " << sample.latency.mean() * static_cast<double>(sample.latency.getCount()) << "\n";
+    os << "lbs_latency_seconds_count " << sample.latency.getCount() << "\n";
+}
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <iostream>
+#include "cadmium/modeling/devs/atomic.hpp"
+#include "stats.hpp"
+
+#ifdef ESP_PLATFORM
+    #include "esp_cpu.h"
+    #include "esp_rom_sys.h"
+    #include "esp_heap_caps.h"
+#else
+    #include <ctime>
+    #include <sys/resource.h>
+#endif
+
+// Cycle counter of the platform: the CPU cycle counter on the ESP32, CLOCK_MONOTONIC
+// (one tick per nanosecond) as the stand-in on POSIX hosts. Only the difference of two
+// readings is meaningful; it stays right across a wrap of the 32-bit ESP32 counter.
+struct cycleCounter {
+#ifdef ESP_PLATFORM
+    using ticks = std::uint32_t;
+
+    static ticks now() {
+        return static_cast<ticks>(esp_cpu_get_cycle_count());
+    }
+
+    static double ticksPerMicrosecond() {
+        return static_cast<double>(esp_rom_get_cpu_ticks_per_us());
+    }
+#else
+    using ticks = std::uint64_t;
+
+    static ticks now() {
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<ticks>(ts.tv_sec) * 1000000000u + static_cast<ticks>(ts.tv_nsec);
+    }
+
+    static double ticksPerMicrosecond() {
+        return 1000.0;
+    }
+#endif
+
+    static double microsecondsSince(ticks start) {
+        return static_cast<double>(static_cast<ticks>(now() - start)) / ticksPerMicrosecond();
+    }
+};
+
+// High-water mark of the heap, in bytes: the lowest free heap the ESP32 allocator has
+// seen, or the peak resident set of the process (getrusage) as the stand-in on hosts
+inline std::size_t heapHighWater() {
+#ifdef ESP_PLATFORM
+    return heap_caps_get_total_size(MALLOC_CAP_DEFAULT) - heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+        return static_cast<std::size_t>(usage.ru_maxrss);         // bytes
+    #else
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024;  // kilobytes
+    #endif
+#endif
+}
+
+// bytes the heap high-water mark rose by since the previous call; a first call before
+// the run sets the baseline
+inline std::size_t heapRise() {
+    static std::size_t mark = 0;
+    std::size_t now = heapHighWater();
+    if (now <= mark) {
+        return 0;
+    }
+    std::size_t rise = now - mark;
+    mark = now;
+    return rise;
+}
+
+// Time spent in the transition functions of a component, in microseconds, and the
+// heap it raised the high-water mark by
+struct transitionProfile {
+    latencyStats internal;
+    latencyStats external;
+    latencyStats output;
+    latencyStats advance;     // time advance after each transition
+    std::size_t heap_raised = 0;
+
+    [[nodiscard]] unsigned long transitions() const {
+        return internal.getCount() + external.getCount();
+    }
+
+    // total time, in microseconds
+    [[nodiscard]] double total() const {
+        double sum = 0.0;
+        for (const latencyStats* stats : {&internal, &external, &output, &advance}) {
+            sum += stats->mean() * static_cast<double>(stats->getCount());
+        }
+        return sum;
+    }
+};
+
+// time of the transitions per job, and the job rate they leave room for
+inline void printProfile(std::ostream& os, const std::string& name, const transitionProfile& profile, unsigned long jobs) {
+    double per_job = jobs > 0 ? profile.total() / static_cast<double>(jobs) : 0.0;
+    os << name << ": " << profile.transitions() << " transitions, " << per_job << " us per job";
+    if (per_job > 0) {
+        os << " (at most " << 1e6 / per_job << " jobs/s)";
+    }
+    os << ", heap high-water raised by " << profile.heap_raised << " bytes" << std::endl;
+    const std::pair<const char*, const latencyStats*> parts[] = {{"internal", &profile.internal}, {"external", &profile.external},
+                                                                 {"output", &profile.output}, {"time advance", &profile.advance}};
+    for (const auto& [part, stats] : parts) {
+        if (stats->getCount() > 0) {
+            os << "  " << part << " (" << stats->getCount() << ", us): ";
+            stats->print(os);
+            os << std::endl;
+        }
+    }
+}
+
+// Atomic model M with its transition functions timed: a drop-in component type for
+// Flat_top (e.g. Flat_top<generator, profiled<balancer>>) or a Cadmium coupled model.
+// State and behaviour are those of M; a confluent transition is timed as its internal
+// and external parts.
+template<typename M>
+class profiled : public M {
+
+    template<typename S>
+    static S stateOf(const cadmium::Atomic<S>&);
+    using S = decltype(stateOf(std::declval<const M&>()));
+
+    public:
+
+    using M::M;
+    using M::internalTransition;
+    using M::externalTransition;
+    using M::output;
+    using M::timeAdvance;
+
+    void internalTransition(S& state) const override {
+        auto start = cycleCounter::now();
+        M::internalTransition(state);
+        profile.internal.add(cycleCounter::microsecondsSince(start));
+        profile.heap_raised += heapRise();
+    }
+
+    void externalTransition(S& state, double e) const override {
+        auto start = cycleCounter::now();
+        M::externalTransition(state, e);
+        profile.external.add(cycleCounter::microsecondsSince(start));
+        profile.heap_raised += heapRise();
+    }
+
+    void output(const S& state) const override {
+        auto start = cycleCounter::now();
+        M::output(state);
+        profile.output.add(cycleCounter::microsecondsSince(start));
+    }
+
+    [[nodiscard]] double timeAdvance(const S& state) const override {
+        auto start = cycleCounter::now();
+        double sigma = M::timeAdvance(state);
+        profile.advance.add(cycleCounter::microsecondsSince(start));
+        return sigma;
+    }
+
+    [[nodiscard]] const transitionProfile& getProfile() const { return profile; }
+
+    private:
+
+    mutable transitionProfile profile;
+};
+
+#endif
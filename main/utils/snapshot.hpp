@@ -0,0 +1,145 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <queue>
+#include <vector>
+#include <type_traits>
+
+// Binary helpers used by the models to checkpoint and restore their state.
+// Values are written in host byte order: a snapshot is meant to be resumed on
+// the machine (and build) that produced it.
+namespace snapshot {
+
+    constexpr char MAGIC[8] = "LBSCKPT";
+    constexpr std::uint32_t VERSION = 18;
+
+    template<typename T>
+    void write(std::ostream& os, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be written directly");
+        os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    bool read(std::istream& is, T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable values can be read directly");
+        is.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return static_cast<bool>(is);
+    }
+
+    inline void write(std::ostream& os, const std::string& value) {
+        write(os, static_cast<std::uint64_t>(value.size()));
+        os.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    inline bool read(std::istream& is, std::string& value) {
+        std::uint64_t size = 0;
+        if (!read(is, size)) {
+            return false;
+        }
+        value.resize(size);
+        is.read(value.data(), static_cast<std::streamsize>(size));
+        return static_cast<bool>(is);
+    }
+
+    template<typename T>
+    void write(std::ostream& os, std::queue<T> queue) {
+        write(os, static_cast<std::uint64_t>(queue.size()));
+        while (!queue.empty()) {
+            write(os, queue.front());
+            queue.pop();
+        }
+    }
+
+    template<typename T>
+    bool read(std::istream& is, std::queue<T>& queue) {
+        std::uint64_t size = 0;
+        if (!read(is, size)) {
+            return false;
+        }
+        queue = std::queue<T>();
+        for (std::uint64_t i = 0; i < size; i++) {
+            T value;
+            if (!read(is, value)) {
+                return false;
+            }
+            queue.push(value);
+        }
+        return true;
+    }
+
+    template<typename T>
+    void write(std::ostream& os, const std::vector<T>& vector) {
+        write(os, static_cast<std::uint64_t>(vector.size()));
+        for (const auto& value : vector) {
+            write(os, value);
+        }
+    }
+
+    template<typename T>
+    bool read(std::istream& is, std::vector<T>& vector) {
+        std::uint64_t size = 0;
+        if (!read(is, size)) {
+            return false;
+        }
+        vector.resize(size);
+        for (auto& value : vector) {
+            if (!read(is, value)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // random engines and distributions only expose their state through the stream operators
+    template<typename Engine>
+    void writeEngine(std::ostream& os, const Engine& engine) {
+        std::ostringstream ss;
+        ss << engine;
+        write(os, ss.str());
+    }
+
+    template<typename Engine>
+    bool readEngine(std::istream& is, Engine& engine) {
+        std::string text;
+        if (!read(is, text)) {
+            return false;
+        }
+        std::istringstream ss(text);
+        ss >> engine;
+        return !ss.fail();
+    }
+
+    // file header: magic, format version and the simulation time of the snapshot
+    inline void writeHeader(std::ostream& os, double time) {
+        os.write(MAGIC, sizeof(MAGIC));
+        write(os, VERSION);
+        write(os, time);
+    }
+
+    inline bool readHeader(std::istream& is, double& time) {
+        char magic[sizeof(MAGIC)] = {};
+        std::uint32_t version = 0;
+        is.read(magic, sizeof(magic));
+        if (!is || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+            std::cerr << "Error: not a simulation snapshot" << std::endl;
+            return false;
+        }
+        if (!read(is, version) || version != VERSION) {
+            std::cerr << "Error: unsupported snapshot version " << version << std::endl;
+            return false;
+        }
+        return read(is, time);
+    }
+
+    // remaining time to the next internal event of a model whose last event happened at last_time
+    inline double remaining(double sigma, double last_time, double time) {
+        return sigma - (time - last_time);
+    }
+}
+
+#endif
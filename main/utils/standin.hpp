@@ -0,0 +1,124 @@
+#ifndef STANDIN_HPP
+#define STANDIN_HPP
+
+#include <chrono>
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "job.hpp"
+
+// Local process doing the work of a server in a load test, e.g. the echo_service
+// stand-in: every job is sent to it and is done when its answer comes back
+struct standinConfig {
+    std::string host = "127.0.0.1";
+    int port = 0;          // 0 for sampled processing times
+    double timeout = 1;    // seconds to wait for an answer before giving up on the call; the whole model waits with it
+
+    [[nodiscard]] bool enabled() const {
+        return port > 0;
+    }
+};
+
+// TCP connection of one server to its stand-in. A job is sent as the line
+// "id class session\n"; the call ends when a full line comes back. The call
+// blocks the caller, and with it the coordinator running the model: the
+// calls of all the servers are serialised.
+class standinClient {
+    public:
+
+    explicit standinClient(const standinConfig& cfg = standinConfig()) : config(cfg) { }
+
+    standinClient(const standinClient&) = delete;
+    standinClient& operator=(const standinClient&) = delete;
+
+    ~standinClient() {
+        disconnect();
+    }
+
+    [[nodiscard]] bool enabled() const {
+        return config.enabled();
+    }
+
+    // wall-clock seconds the stand-in took to answer the job, negative if the call failed
+    double call(const job& item) {
+        auto start = std::chrono::steady_clock::now();
+        if (fd < 0 && !connectTo()) {
+            return -1.0;
+        }
+        std::string request = std::to_string(item.id) + " " + std::to_string(item.job_class) + " " + std::to_string(item.session) + "\n";
+        if (!sendAll(request) || !readLine()) {
+            disconnect();  // reconnect at the next call
+            return -1.0;
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    private:
+
+    standinConfig config;
+    int fd = -1;
+
+    bool connectTo() {
+        fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return false;
+        }
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(config.port));
+        timeval limit{};
+        limit.tv_sec = static_cast<long>(config.timeout);
+        limit.tv_usec = static_cast<long>((config.timeout - static_cast<double>(limit.tv_sec)) * 1e6);
+        int no_delay = 1;
+        if (::inet_pton(AF_INET, config.host.c_str(), &address.sin_addr) != 1
+            || ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit)) != 0
+            || ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit)) != 0
+            || ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay)) != 0
+            || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            disconnect();
+            return false;
+        }
+        return true;
+    }
+
+    void disconnect() {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    bool sendAll(const std::string& data) {
+        std::size_t sent = 0;
+        while (sent < data.size()) {
+            auto n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+            if (n <= 0) {
+                return false;
+            }
+            sent += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    // reads up to the end of the answer; one call is in flight at a time, so nothing follows it
+    bool readLine() {
+        char buffer[256];
+        while (true) {
+            auto n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return false;
+            }
+            if (std::memchr(buffer, '\n', static_cast<std::size_t>(n)) != nullptr) {
+                return true;
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef STATS_HPP
+#define STATS_HPP
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <iostream>
+
+// Latency accumulator with constant memory: a histogram with log-spaced buckets
+// (BUCKETS_PER_DECADE per decade from MIN_VALUE to MAX_VALUE), plus exact count,
+// mean and maximum. Quantiles are exact to within one bucket (about 12%).
+// Trivially copyable, so it is checkpointed as is.
+class latencyStats {
+    public:
+
+    static constexpr double MIN_VALUE = 1e-4;
+    static constexpr double MAX_VALUE = 1e5;
+    static constexpr int BUCKETS_PER_DECADE = 20;
+    static constexpr int BUCKETS = 9 * BUCKETS_PER_DECADE + 2;  // + underflow and overflow
+
+    void add(double value) {
+        buckets[bucket(value)]++;
+        count++;
+        sum += value;
+        if (value > max) {
+            max = value;
+        }
+    }
+
+    void merge(const latencyStats& other) {
+        for (int i = 0; i < BUCKETS; i++) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        if (other.max > max) {
+            max = other.max;
+        }
+    }
+
+    [[nodiscard]] unsigned long getCount() const { return count; }
+    [[nodiscard]] double getMax() const { return max; }
+
+    [[nodiscard]] double mean() const {
+        return count == 0 ? 0.0 : sum / static_cast<double>(count);
+    }
+
+    // upper bound of the bucket holding the q-quantile (0 < q <= 1)
+    [[nodiscard]] double quantile(double q) const {
+        if (count == 0) {
+            return 0.0;
+        }
+        auto rank = static_cast<unsigned long>(std::ceil(q * static_cast<double>(count)));
+        unsigned long seen = 0;
+        for (int i = 0; i < BUCKETS; i++) {
+            seen += buckets[i];
+            if (seen >= rank && seen > 0) {
+                return i == BUCKETS - 1 ? max : std::min(upperBound(i), max);
+            }
+        }
+        return max;
+    }
+
+    void print(std::ostream& os) const {
+        os << "mean " << mean() << ", p50 " << quantile(0.50) << ", p95 " << quantile(0.95)
+           << ", p99 " << quantile(0.99) << ", max " << max;
+    }
+
+    private:
+
+    std::array<unsigned long, BUCKETS> buckets{};
+    unsigned long count = 0;
+    double sum = 0.0;
+    double max = 0.0;
+
+    static int bucket(double value) {
+        if (value < MIN_VALUE) {
+            return 0;
+        }
+        int i = 1 + static_cast<int>(std::floor(std::log10(value / MIN_VALUE) * BUCKETS_PER_DECADE));
+        return i >= BUCKETS ? BUCKETS - 1 : i;
+    }
+
+    static double upperBound(int i) {
+        return MIN_VALUE * std::pow(10.0, static_cast<double>(i) / BUCKETS_PER_DECADE);
+    }
+};
+
+// Number of events per fixed window of simulated time, e.g. completions per minute.
+// With a window limit the memory is bounded: once an event falls past the last
+// window, neighbouring windows are merged in pairs and the window doubles.
+class timeline {
+    public:
+
+    explicit timeline(double window_size = 60.0, std::size_t max_windows = 0) : window(window_size), limit(max_windows) { }
+
+    void add(double time) {
+        auto i = static_cast<std::size_t>(time / window);
+        while (limit > 0 && i >= limit) {
+            compact();
+            i = static_cast<std::size_t>(time / window);
+        }
+        if (i >= counts.size()) {
+            counts.resize(i + 1, 0);
+        }
+        counts[i]++;
+    }
+
+    // adds the events of a timeline with the same base window, compacted or not
+    void merge(const timeline& other) {
+        while (window < other.window) {
+            compact();
+        }
+        auto factor = static_cast<std::size_t>(std::lround(window / other.window));
+        std::size_t size = (other.counts.size() + factor - 1) / factor;
+        if (size > counts.size()) {
+            counts.resize(size, 0);
+        }
+        for (std::size_t i = 0; i < other.counts.size(); i++) {
+            counts[i / factor] += other.counts[i];
+        }
+    }
+
+    [[nodiscard]] double getWindow() const { return window; }
+    [[nodiscard]] std::size_t getLimit() const { return limit; }
+    [[nodiscard]] const std::vector<int>& getCounts() const { return counts; }
+    std::vector<int>& getCounts() { return counts; }
+
+    // one line per window: start time and events per second
+    void print(std::ostream& os) const {
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            os << "  " << static_cast<double>(i) * window << "\t" << counts[i] / window << "/s" << std::endl;
+        }
+    }
+
+    private:
+
+    double window;
+    std::size_t limit;  // windows kept, 0 for no limit
+    std::vector<int> counts;
+
+    // doubles the window, merging the counts of each pair of windows
+    void compact() {
+        for (std::size_t i = 0; i < counts.size(); i++) {
+            counts[i / 2] = (i % 2 == 0) ? counts[i] : counts[i / 2] + counts[i];
+        }
+        counts.resize((counts.size() + 1) / 2);
+        counts.shrink_to_fit();
+        window *= 2;
+    }
+};
+
+#endif
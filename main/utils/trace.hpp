@@ -0,0 +1,73 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "job.hpp"
+
+// One request of a captured request log
+struct traceRecord {
+    double time;    // arrival, seconds after the first request of the log
+    int job_class;
+    int session;    // 0 for none
+};
+
+// Reads a request log to replay: one request per line, "time[,class[,session]]",
+// with times in seconds from any origin (e.g. Unix timestamps) in arrival order.
+// Blank lines and lines starting with # are skipped. Times are made relative to
+// the first request and divided by speedup (2 replays the log twice as fast).
+inline bool loadTrace(const std::string& path, double speedup, std::vector<traceRecord>& trace) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open request log: " << path << std::endl;
+        return false;
+    }
+    trace.clear();
+    std::string line;
+    int line_number = 0;
+    double first = 0.0;
+    while (std::getline(file, line)) {
+        line_number++;
+        auto start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') {
+            continue;
+        }
+        for (char& c : line) {
+            if (c == ',') {
+                c = ' ';
+            }
+        }
+        std::istringstream fields(line);
+        std::vector<double> values;
+        double value = 0.0;
+        while (fields >> value) {
+            values.push_back(value);
+        }
+        traceRecord record{0.0, values.size() > 1 ? static_cast<int>(values[1]) : 0, values.size() > 2 ? static_cast<int>(values[2]) : 0};
+        if (!fields.eof() || values.empty() || values.size() > 3 || record.job_class < 0 || record.job_class >= job::MAX_CLASSES || record.session < 0) {
+            std::cerr << "Error: " << path << ":" << line_number << ": expected time[,class[,session]] with a class from 0 to "
+                      << job::MAX_CLASSES - 1 << " and a session >= 0" << std::endl;
+            return false;
+        }
+        double time = values[0];
+        if (trace.empty()) {
+            first = time;
+        }
+        record.time = (time - first) / speedup;
+        if (!trace.empty() && record.time < trace.back().time) {
+            std::cerr << "Error: " << path << ":" << line_number << ": requests must be in arrival order" << std::endl;
+            return false;
+        }
+        trace.push_back(record);
+    }
+    if (trace.empty()) {
+        std::cerr << "Error: " << path << ": no request to replay" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#!/bin/bash
+# Build (incrementally) and run a load test: the echo_service stand-in in the background
+# and the scenario on the wall clock
+# Usage: ./scripts/run_loadtest.sh [scenario.ini] [delay] [constant|exponential]
+#        (default: main/scenarios/loadtest.ini, stand-in delay 0.05 s exponential)
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+SCENARIO=${1:-main/scenarios/loadtest.ini}
+DELAY=${2:-0.05}
+DISTRIBUTION=${3:-exponential}
+PORT=$(sed -n '/^\[standin\]/,/^\[/s/^port *= *\([0-9]*\).*/\1/p' "$SCENARIO")
+PORT=${PORT:-9000}
+
+echo "================================"
+echo "Building Load Test"
+echo "================================"
+
+mkdir -p build && cd build || exit
+if [ ! -f CMakeCache.txt ]; then cmake .. -DSIM=ON > /dev/null 2>&1; fi
+make run_loadtest echo_service || exit
+
+echo ""
+echo "================================"
+echo "Running Load Test $SCENARIO"
+echo "================================"
+cd ..
+mkdir -p simulation_results
+./bin/echo_service "$PORT" "$DELAY" "$DISTRIBUTION" &
+ECHO_PID=$!
+sleep 0.5
+./bin/run_loadtest "$SCENARIO" > /dev/null
+kill $ECHO_PID
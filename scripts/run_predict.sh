@@ -0,0 +1,26 @@
+#!/bin/bash
+# Build (incrementally) and print the queueing model of a scenario file
+# Usage: ./scripts/run_predict.sh [--compare] [scenario.ini]   (default: main/scenarios/default.ini)
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+COMPARE=""
+if [ "$1" == "--compare" ]; then COMPARE="--compare"; shift; fi
+SCENARIO=${1:-main/scenarios/default.ini}
+
+echo "================================"
+echo "Building Queueing Model"
+echo "================================"
+
+mkdir -p build && cd build || exit
+if [ ! -f CMakeCache.txt ]; then cmake .. -DSIM=ON > /dev/null 2>&1; fi
+make predict_scenario || exit
+
+echo ""
+echo "================================"
+echo "Predicting Scenario $SCENARIO"
+echo "================================"
+cd ..
+mkdir -p simulation_results
+./bin/predict_scenario $COMPARE "$SCENARIO"
@@ -0,0 +1,25 @@
+#!/bin/bash
+# Build (incrementally) and profile the transitions of the flat Top model on this host
+# Usage: ./scripts/run_profile.sh [--quiet] [scenario.ini]   (default: main/scenarios/default.ini)
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+QUIET=""
+if [ "$1" == "--quiet" ]; then QUIET="--quiet"; shift; fi
+SCENARIO=${1:-main/scenarios/default.ini}
+
+echo "================================"
+echo "Building Profiler"
+echo "================================"
+
+mkdir -p build && cd build || exit
+if [ ! -f CMakeCache.txt ]; then cmake .. -DSIM=ON > /dev/null 2>&1; fi
+make profile_model || exit
+
+echo ""
+echo "================================"
+echo "Profiling Scenario $SCENARIO"
+echo "================================"
+cd ..
+./bin/profile_model $QUIET "$SCENARIO" > /dev/null
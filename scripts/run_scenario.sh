@@ -0,0 +1,24 @@
+#!/bin/bash
+# Build (incrementally) and run a scenario file
+# Usage: ./scripts/run_scenario.sh [scenario.ini]   (default: main/scenarios/default.ini)
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+SCENARIO=${1:-main/scenarios/default.ini}
+
+echo "================================"
+echo "Building Scenario Runner"
+echo "================================"
+
+mkdir -p build && cd build || exit
+if [ ! -f CMakeCache.txt ]; then cmake .. -DSIM=ON > /dev/null 2>&1; fi
+make run_scenario || exit
+
+echo ""
+echo "================================"
+echo "Running Scenario $SCENARIO"
+echo "================================"
+cd ..
+mkdir -p simulation_results
+./bin/run_scenario "$SCENARIO" > /dev/null
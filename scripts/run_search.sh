@@ -0,0 +1,23 @@
+#!/bin/bash
+# Build (incrementally) and search the cheapest configuration of a scenario that meets a p99 target
+# Usage: ./scripts/run_search.sh [search.ini]   (default: main/scenarios/capacity_search.ini)
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+SEARCH=${1:-main/scenarios/capacity_search.ini}
+
+echo "================================"
+echo "Building Capacity Search"
+echo "================================"
+
+mkdir -p build && cd build || exit
+if [ ! -f CMakeCache.txt ]; then cmake .. -DSIM=ON > /dev/null 2>&1; fi
+make search_scenario || exit
+
+echo ""
+echo "================================"
+echo "Searching $SEARCH"
+echo "================================"
+cd ..
+./bin/search_scenario "$SEARCH"
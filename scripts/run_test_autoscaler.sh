@@ -0,0 +1,26 @@
+#!/bin/bash
+# Build and run the autoscaler test
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+echo "================================"
+echo "Building Autoscaler Test"
+echo "================================"
+
+if [ -d "build" ]; then rm -Rf build; fi
+mkdir -p build && cd build || exit
+cmake .. -DSIM=ON > /dev/null 2>&1
+make test_autoscaler
+
+echo ""
+echo "================================"
+echo "Running Autoscaler Test"
+echo "================================"
+cd ..
+rm -f simulation_results/autoscaler_log.txt
+rm -f simulation_results/autoscaler_output.csv
+./bin/test_autoscaler
+echo ""
+echo "Readable output saved to: simulation_results/autoscaler_log.txt"
+echo "Cadmium logger output saved to: simulation_results/autoscaler_output.csv"
\ No newline at end of file
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Build and run the TOP model checkpoint test
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+echo "================================"
+echo "Building Checkpoint Test"
+echo "================================"
+
+if [ -d "build" ]; then rm -Rf build; fi
+mkdir -p build && cd build || exit
+cmake .. -DSIM=ON > /dev/null 2>&1
+make test_checkpoint
+
+echo ""
+echo "================================"
+echo "Running Checkpoint Test"
+echo "================================"
+cd ..
+rm -f simulation_results/checkpoint_log.txt
+rm -f simulation_results/top_checkpoint.bin
+./bin/test_checkpoint > /dev/null
+echo ""
+echo "Readable output saved to: simulation_results/checkpoint_log.txt"
+echo "Snapshot saved to: simulation_results/top_checkpoint.bin"
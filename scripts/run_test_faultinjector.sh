@@ -0,0 +1,26 @@
+#!/bin/bash
+# Build and run the fault injector test
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+echo "================================"
+echo "Building Fault Injector Test"
+echo "================================"
+
+if [ -d "build" ]; then rm -Rf build; fi
+mkdir -p build && cd build || exit
+cmake .. -DSIM=ON > /dev/null 2>&1
+make test_faultinjector
+
+echo ""
+echo "================================"
+echo "Running Fault Injector Test"
+echo "================================"
+cd ..
+rm -f simulation_results/faultinjector_log.txt
+rm -f simulation_results/faultinjector_output.csv
+./bin/test_faultinjector
+echo ""
+echo "Readable output saved to: simulation_results/faultinjector_log.txt"
+echo "Cadmium logger output saved to: simulation_results/faultinjector_output.csv"
\ No newline at end of file
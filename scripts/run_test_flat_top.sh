@@ -0,0 +1,26 @@
+#!/bin/bash
+# Build and run the flattened TOP model benchmark
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+echo "================================"
+echo "Building Flat TOP Test"
+echo "================================"
+
+if [ -d "build" ]; then rm -Rf build; fi
+mkdir -p build && cd build || exit
+cmake .. -DSIM=ON > /dev/null 2>&1
+make test_flat_top
+
+echo ""
+echo "================================"
+echo "Running Flat TOP Test"
+echo "================================"
+cd ..
+rm -f simulation_results/flat_top_log.txt
+rm -f simulation_results/flat_top_generic_log.txt
+./bin/test_flat_top > /dev/null
+echo ""
+echo "Readable output saved to: simulation_results/flat_top_log.txt"
+echo "Generic model output saved to: simulation_results/flat_top_generic_log.txt"
@@ -0,0 +1,25 @@
+#!/bin/bash
+# Build and run the hedging over network links test
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+echo "================================"
+echo "Building Hedging Test"
+echo "================================"
+
+if [ -d "build" ]; then rm -Rf build; fi
+mkdir -p build && cd build || exit
+cmake .. -DSIM=ON > /dev/null 2>&1
+make test_hedging
+
+echo ""
+echo "================================"
+echo "Running Hedging Test"
+echo "================================"
+cd ..
+rm -f simulation_results/hedging_test_log.txt
+rm -f simulation_results/hedging_test_flat_log.txt
+./bin/test_hedging > /dev/null
+echo ""
+echo "Readable output saved to: simulation_results/hedging_test_log.txt"
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Build and run the work stealer test
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+echo "================================"
+echo "Building WAN Link Test"
+echo "================================"
+
+if [ -d "build" ]; then rm -Rf build; fi
+mkdir -p build && cd build || exit
+cmake .. -DSIM=ON > /dev/null 2>&1
+make test_wanlink
+
+echo ""
+echo "================================"
+echo "Running WAN Link Test"
+echo "================================"
+cd ..
+rm -f simulation_results/wanlink_log.txt
+rm -f simulation_results/wanlink_output.csv
+./bin/test_wanlink
+echo ""
+echo "Readable output saved to: simulation_results/wanlink_log.txt"
+echo "Cadmium logger output saved to: simulation_results/wanlink_output.csv"
\ No newline at end of file
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Build and run the work stealer test
+
+cd "$(dirname "$0")/." || exit
+cd ..
+
+echo "================================"
+echo "Building Work Stealer Test"
+echo "================================"
+
+if [ -d "build" ]; then rm -Rf build; fi
+mkdir -p build && cd build || exit
+cmake .. -DSIM=ON > /dev/null 2>&1
+make test_workstealer
+
+echo ""
+echo "================================"
+echo "Running Work Stealer Test"
+echo "================================"
+cd ..
+rm -f simulation_results/workstealer_log.txt
+rm -f simulation_results/workstealer_output.csv
+./bin/test_workstealer
+echo ""
+echo "Readable output saved to: simulation_results/workstealer_log.txt"
+echo "Cadmium logger output saved to: simulation_results/workstealer_output.csv"
\ No newline at end of file